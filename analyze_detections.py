@@ -1,4 +1,5 @@
 import re
+import struct
 import matplotlib
 matplotlib.use('Agg')  # 设置后端为Agg，避免GUI相关问题
 import matplotlib.pyplot as plt
@@ -6,6 +7,86 @@ import numpy as np
 import argparse
 import os
 
+# 二进制结果格式定义，与xsense_npu_test.c中的RESULT_BIN_*保持一致
+RESULT_BIN_MAGIC = 0x42525358  # "XSRB"
+RESULT_BIN_HEADER_FORMAT = '<2I'   # magic, version
+RESULT_BIN_FRAME_FORMAT = '<3I'    # frame_id, inst_id, obj_num
+RESULT_BIN_OBJ_FORMAT = '<7i'      # rect(4个坐标), obj_id, score, type
+
+
+def is_bin_result_file(file_path):
+    """
+    判断结果文件是否为二进制格式（--result_format bin的输出）
+
+    Args:
+        file_path (str): 结果文件路径
+
+    Returns:
+        bool: 是否为二进制结果文件
+    """
+    try:
+        with open(file_path, 'rb') as f:
+            header = f.read(struct.calcsize(RESULT_BIN_HEADER_FORMAT))
+        if len(header) < struct.calcsize(RESULT_BIN_HEADER_FORMAT):
+            return False
+        magic, _ = struct.unpack(RESULT_BIN_HEADER_FORMAT, header)
+        return magic == RESULT_BIN_MAGIC
+    except OSError:
+        return False
+
+
+def iter_bin_records(file_path):
+    """
+    逐条读取二进制结果记录
+
+    Args:
+        file_path (str): 二进制结果文件路径
+
+    Yields:
+        tuple: (frame_id, inst_id, objects)，objects为对象记录元组列表
+    """
+    frame_size = struct.calcsize(RESULT_BIN_FRAME_FORMAT)
+    obj_size = struct.calcsize(RESULT_BIN_OBJ_FORMAT)
+    with open(file_path, 'rb') as f:
+        f.seek(struct.calcsize(RESULT_BIN_HEADER_FORMAT))
+        while True:
+            frame_data = f.read(frame_size)
+            if len(frame_data) < frame_size:
+                break
+            frame_id, inst_id, obj_num = struct.unpack(RESULT_BIN_FRAME_FORMAT, frame_data)
+            objects = []
+            for _ in range(obj_num):
+                obj_data = f.read(obj_size)
+                if len(obj_data) < obj_size:
+                    return
+                objects.append(struct.unpack(RESULT_BIN_OBJ_FORMAT, obj_data))
+            yield frame_id, inst_id, objects
+
+
+def parse_bin_file(file_path):
+    """
+    解析二进制结果文件，提取score值和帧标识（二进制记录不带文件路径，
+    用frame_帧号代替文件名，保持和文本解析相同的返回结构）
+
+    Args:
+        file_path (str): 二进制结果文件路径
+
+    Returns:
+        tuple: (scores列表, 文件名列表)
+    """
+    scores = []
+    filenames = []
+    for frame_id, inst_id, objects in iter_bin_records(file_path):
+        name = f"frame_{frame_id:06d}"
+        if objects:
+            # 与文本解析一致：每帧取第一个对象的score
+            scores.append(objects[0][5])
+        else:
+            scores.append(0)
+        filenames.append(name)
+    return scores, filenames
+
+
 def parse_log_file(file_path):
     """
     解析日志文件，提取所有的score值和对应的文件名
@@ -16,11 +97,15 @@ def parse_log_file(file_path):
     Returns:
         tuple: (scores列表, 文件名列表)
     """
+    # 二进制结果文件走专用解析
+    if is_bin_result_file(file_path):
+        return parse_bin_file(file_path)
+
     scores = []
     filenames = []
     with open(file_path, 'r', encoding='utf-8') as f:
         content = f.read()
-        
+
     # 使用正则表达式匹配File行和score值
     file_blocks = content.split('File: ')[1:]  # 分割成块，每块是一个文件的信息
     
@@ -132,9 +217,13 @@ def count_files(file_path):
     Returns:
         int: 文件数量
     """
+    # 二进制结果文件：帧记录数即文件数
+    if is_bin_result_file(file_path):
+        return sum(1 for _ in iter_bin_records(file_path))
+
     with open(file_path, 'r', encoding='utf-8') as f:
         content = f.read()
-    
+
     # 使用正则表达式匹配File行
     file_pattern = r'File:.*'
     file_matches = re.findall(file_pattern, content)
@@ -151,9 +240,13 @@ def count_detected_files(file_path):
     Returns:
         int: 包含检测结果的文件数量
     """
+    # 二进制结果文件：统计带对象记录的帧数
+    if is_bin_result_file(file_path):
+        return sum(1 for _, _, objects in iter_bin_records(file_path) if objects)
+
     with open(file_path, 'r', encoding='utf-8') as f:
         content = f.read()
-    
+
     # 使用File分割符来分割文件块，然后检查每个文件块是否包含检测结果
     file_blocks = content.split('File: ')[1:]  # 分割成块，每块是一个文件的信息
     detected_count = 0
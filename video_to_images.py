@@ -1,8 +1,30 @@
 import cv2
 import os
 import argparse
+import struct
 import numpy as np
 
+# yuvseq容器魔数，与xsense_npu_test.c中的YUVSEQ_MAGIC保持一致 ("YSEQ")
+YUVSEQ_MAGIC = 0x51455359
+YUVSEQ_VERSION = 1
+# 容器头固定32字节: magic, version, width, height, frame_count, reserved[3]
+YUVSEQ_HEADER_FORMAT = '<8I'
+
+
+def write_yuvseq_header(f, width, height, frame_count):
+    """
+    写入yuvseq容器头（定位到文件开头后写入）
+
+    Args:
+        f: 已打开的二进制文件对象
+        width (int): 帧宽度
+        height (int): 帧高度
+        frame_count (int): 帧数量
+    """
+    f.seek(0)
+    f.write(struct.pack(YUVSEQ_HEADER_FORMAT, YUVSEQ_MAGIC, YUVSEQ_VERSION,
+                        width, height, frame_count, 0, 0, 0))
+
 def bgr_to_nv12(image):
     """
     将BGR图像转换为NV12格式
@@ -71,7 +93,15 @@ def video_to_images(video_path, output_dir, frame_interval=1, width=640, height=
     
     frame_count = 0
     saved_count = 0
-    
+
+    # yuvseq模式：所有帧写入单个容器文件，先写占位头，结束后回填帧数
+    yuvseq_file = None
+    if output_format.lower() == 'yuvseq':
+        video_name = os.path.splitext(os.path.basename(video_path))[0]
+        yuvseq_path = os.path.join(output_dir, f"{video_name}.yuvseq")
+        yuvseq_file = open(yuvseq_path, 'wb')
+        write_yuvseq_header(yuvseq_file, width, height, 0)
+
     while True:
         # 读取一帧
         ret, frame = cap.read()
@@ -95,6 +125,11 @@ def video_to_images(video_path, output_dir, frame_interval=1, width=640, height=
                 nv12_frame = bgr_to_nv12(resized_frame)
                 with open(output_filename, 'wb') as f:
                     f.write(nv12_frame)
+            elif output_format.lower() == 'yuvseq':
+                # 转换BGR到NV12格式并追加到容器
+                nv12_frame = bgr_to_nv12(resized_frame)
+                yuvseq_file.write(nv12_frame)
+                output_filename = f"{yuvseq_file.name}#{saved_count:06d}"
             elif output_format.lower() == 'rgb':
                 output_filename = os.path.join(output_dir, f"frame_{saved_count:06d}.rgb")
                 # 转换BGR到RGB
@@ -113,7 +148,13 @@ def video_to_images(video_path, output_dir, frame_interval=1, width=640, height=
     
     # 释放视频捕获对象
     cap.release()
-    
+
+    # yuvseq模式：回填容器头中的实际帧数
+    if yuvseq_file is not None:
+        write_yuvseq_header(yuvseq_file, width, height, saved_count)
+        yuvseq_file.close()
+        print(f"yuvseq容器已保存: {yuvseq_file.name} (共{saved_count}帧)")
+
     print(f"完成！共保存 {saved_count} 张图片到 {output_dir}")
 
 # 新增功能：将目录下的所有图片文件转换为YUV格式
@@ -193,8 +234,8 @@ def main():
     parser.add_argument("-i", "--interval", type=int, default=1, help="帧间隔 (默认: 1)")
     parser.add_argument("-w", "--width", type=int, default=640, help="输出图像宽度 (默认: 640)")
     parser.add_argument("-H", "--height", type=int, default=360, help="输出图像高度 (默认: 360)")
-    parser.add_argument("-f", "--format", choices=['jpeg', 'yuv', 'rgb'], default='jpeg', 
-                        help="输出图像格式: jpeg, yuv, rgb (默认: jpeg)")
+    parser.add_argument("-f", "--format", choices=['jpeg', 'yuv', 'rgb', 'yuvseq'], default='jpeg',
+                        help="输出图像格式: jpeg, yuv, rgb, yuvseq (默认: jpeg)")
     parser.add_argument("--images-to-yuv", action="store_true", 
                         help="将输入目录中的所有图片转换为YUV格式")
     
@@ -20,6 +20,11 @@ extern "C" {
 #endif
 #endif /* End of #ifdef __cplusplus */
 
+// pthread_setaffinity_np/CPU_SET需要GNU扩展
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -36,16 +41,23 @@ extern "C" {
 #include <unistd.h>
 #include <dirent.h>  // 添加目录操作头文件
 #include <sys/stat.h> // 添加文件状态头文件
+#include <sys/mman.h> // 添加内存映射头文件
+#include <sched.h>    // 添加sched_yield头文件
+#include <ctype.h>    // 添加isdigit头文件
+#include <malloc.h>   // 添加mallinfo头文件
+#include <sys/resource.h> // 添加getrusage头文件
+#include <sys/socket.h>   // 添加套接字头文件
+#include <sys/un.h>       // 添加UNIX域套接字头文件
+#include <netinet/in.h>   // 添加TCP套接字地址头文件
+#include <arpa/inet.h>    // 添加协调端地址解析头文件
+#include <sys/eventfd.h>  // 添加退出事件fd头文件
+#include <poll.h>         // 添加poll头文件
 
 //#include "rtsp_demo.h"
 #include "sample_comm.h"
 
-// 全局信号量，用于同步IVA处理完成事件
-static sem_t g_iva_semaphore;
 // 控制是否启用睡眠模式的标志位
 static RK_S32 g_enable_sleep = 1;
-// IVA上下文结构体，包含IVA相关配置和状态
-static SAMPLE_IVA_CTX_S iva_ctx;
 // 输入图像文件路径
 static char *path = NULL;
 // 循环处理次数，-1表示未设置
@@ -56,9 +68,11 @@ static bool quit = false;
 static int quit_result = RK_SUCCESS;
 
 // 目录模式下的YUV文件列表和相关信息
+// 路径字节集中存放在一块连续arena中，yuv_files是指向arena内部的指针表，
+// 免去几十万次strdup的小块分配和堆碎片
 static char **yuv_files = NULL;
+static char *g_yuv_path_arena = NULL;
 static int yuv_file_count = 1;
-static int current_file_index = 0;
 static RK_CHAR *pIvaModelPath = "/tmp/";
 static RK_CHAR *pIvaModelName = "iva_object_detection_v3_pfp_nn_640x384.data";
 
@@ -66,26 +80,1198 @@ static RK_CHAR *pIvaModelName = "iva_object_detection_v3_pfp_nn_640x384.data";
 static FILE *result_output_file = NULL;
 static char *result_output_path = NULL;
 
+// 二进制结果输出模式（--result_format bin）：回调只做定长记录拼装，
+// 经用户态大缓冲聚合后批量落盘，把格式化和fflush开销移出结果线程
+static RK_S32 g_result_format_bin = 0;
+#define RESULT_BIN_MAGIC 0x42525358  // "XSRB"
+#define RESULT_BIN_VERSION 1
+#define RESULT_BIN_BUF_SIZE (4 * 1024 * 1024)
+#define RESULT_BIN_FLUSH_INTERVAL_MS 1000
+
+// 二进制文件头，写在结果文件开头
+typedef struct __attribute__((packed)) {
+	RK_U32 magic;
+	RK_U32 version;
+} RESULT_BIN_HEADER_S;
+
+// 每帧一条帧记录，后跟obj_num条对象记录
+typedef struct __attribute__((packed)) {
+	RK_U32 frame_id;
+	RK_U32 inst_id;
+	RK_U32 obj_num;
+} RESULT_BIN_FRAME_S;
+
+typedef struct __attribute__((packed)) {
+	RK_S32 top_left_x;
+	RK_S32 top_left_y;
+	RK_S32 bottom_right_x;
+	RK_S32 bottom_right_y;
+	RK_S32 obj_id;
+	RK_S32 score;
+	RK_S32 type;
+} RESULT_BIN_OBJ_S;
+
+static RK_U8 *g_result_bin_buf = NULL;
+static RK_U32 g_result_bin_used = 0;
+static long g_result_bin_last_flush_ms = 0;
+
+// 协调/工作端模式（--coordinator / --worker）：以前整机架扫描靠shell
+// 脚本手工切目录再合并结果，板子快慢不均就得等最慢的那台。现在一台
+// 板子当协调端，按批下发文件索引区间；其余板子起工作端，按需领批、
+// 跑原有的读取/提交流水线，二进制结果记录经同一条TCP连接流回协调端
+// 合并成单个输出文件。慢板子自然少领几批，负载自动均衡。前提：数据
+// 目录在各板以相同路径可见（索引排序一致，协调端只下发下标区间）
+#define COORD_MSG_MAGIC 0x51575358  // "XSWQ"
+#define COORD_BATCH_FILES 64        // 单批文件数：够摊薄往返，也够细分负载
+enum {
+	COORD_MSG_WORK_REQ = 1,    // 工作端->协调端：请求一批
+	COORD_MSG_WORK_GRANT = 2,  // 协调端->工作端：下发[arg0, arg0+arg1)
+	COORD_MSG_RESULT = 3,      // 工作端->协调端：arg0字节的二进制结果负载
+};
+
+typedef struct __attribute__((packed)) {
+	RK_U32 magic;
+	RK_U32 type;
+	RK_U32 arg0;  // GRANT: 起始下标; RESULT: 负载字节数
+	RK_U32 arg1;  // GRANT: 文件数（0表示活派完了）
+} COORD_MSG_S;
+
+static char *g_coordinator_port = NULL;  // --coordinator <port>
+static char *g_worker_spec = NULL;       // --worker <host:port>
+static RK_S32 g_worker_fd = -1;
+// 同一条连接上REQ（读线程）和RESULT（结果回调）都会发，
+// 整条消息的写入需要串行化，否则帧格式在对端错位
+static pthread_mutex_t g_coord_io_mutex = PTHREAD_MUTEX_INITIALIZER;
+// 工作端当前批次游标；只有读文件线程消费，无需加锁
+static RK_S32 g_worker_batch_next = 0;
+static RK_S32 g_worker_batch_left = 0;
+
+// 整块写socket，处理短写与EINTR
+static RK_S32 coord_write_full(RK_S32 fd, const void *buf, size_t len) {
+	const RK_U8 *p = (const RK_U8 *)buf;
+	while (len > 0) {
+		ssize_t n = write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return RK_FAILURE;
+		}
+		p += n;
+		len -= (size_t)n;
+	}
+	return RK_SUCCESS;
+}
+
+// 整块读socket；对端关闭或出错返回失败
+static RK_S32 coord_read_full(RK_S32 fd, void *buf, size_t len) {
+	RK_U8 *p = (RK_U8 *)buf;
+	while (len > 0) {
+		ssize_t n = read(fd, p, len);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return RK_FAILURE;
+		p += n;
+		len -= (size_t)n;
+	}
+	return RK_SUCCESS;
+}
+
+// 工作端：把聚合好的一段二进制结果记录发回协调端
+static RK_S32 coord_send_result(const void *buf, RK_U32 len) {
+	COORD_MSG_S msg = {COORD_MSG_MAGIC, COORD_MSG_RESULT, len, 0};
+	pthread_mutex_lock(&g_coord_io_mutex);
+	RK_S32 ret = coord_write_full(g_worker_fd, &msg, sizeof(msg));
+	if (ret == RK_SUCCESS)
+		ret = coord_write_full(g_worker_fd, buf, len);
+	pthread_mutex_unlock(&g_coord_io_mutex);
+	if (ret != RK_SUCCESS)
+		RK_LOGE("send results to coordinator failed because %s", strerror(errno));
+	return ret;
+}
+
+// 工作端：当前批耗尽时向协调端再领一批。返回全局文件下标，-1表示
+// 全局扫完（或连接断开）。应答只有GRANT一种且只有本线程在读
+static RK_S32 worker_next_index(void) {
+	if (g_worker_batch_left <= 0) {
+		COORD_MSG_S msg = {COORD_MSG_MAGIC, COORD_MSG_WORK_REQ, 0, 0};
+		pthread_mutex_lock(&g_coord_io_mutex);
+		RK_S32 ret = coord_write_full(g_worker_fd, &msg, sizeof(msg));
+		pthread_mutex_unlock(&g_coord_io_mutex);
+		if (ret != RK_SUCCESS)
+			return -1;
+		if (coord_read_full(g_worker_fd, &msg, sizeof(msg)) != RK_SUCCESS ||
+		    msg.magic != COORD_MSG_MAGIC || msg.type != COORD_MSG_WORK_GRANT)
+			return -1;
+		if (msg.arg1 == 0)
+			return -1;
+		g_worker_batch_next = (RK_S32)msg.arg0;
+		g_worker_batch_left = (RK_S32)msg.arg1;
+		RK_LOGI("worker granted batch [%u, %u)", msg.arg0, msg.arg0 + msg.arg1);
+	}
+	g_worker_batch_left--;
+	return g_worker_batch_next++;
+}
+
+// 工作端：连接协调端，spec形如host:port（host用点分IP）
+static RK_S32 worker_connect(const char *spec) {
+	char host[128];
+	const char *colon = strrchr(spec, ':');
+	if (!colon || colon == spec) {
+		RK_LOGE("bad --worker spec %s, expect host:port", spec);
+		return RK_FAILURE;
+	}
+	size_t host_len = (size_t)(colon - spec);
+	if (host_len >= sizeof(host))
+		host_len = sizeof(host) - 1;
+	memcpy(host, spec, host_len);
+	host[host_len] = '\0';
+
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons((unsigned short)atoi(colon + 1));
+	if (inet_aton(host, &addr.sin_addr) == 0) {
+		RK_LOGE("bad coordinator address %s (numeric IP expected)", host);
+		return RK_FAILURE;
+	}
+	RK_S32 fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		RK_LOGE("socket failed because %s", strerror(errno));
+		return RK_FAILURE;
+	}
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		RK_LOGE("connect %s failed because %s", spec, strerror(errno));
+		close(fd);
+		return RK_FAILURE;
+	}
+	g_worker_fd = fd;
+	RK_LOGI("connected to coordinator %s", spec);
+	return RK_SUCCESS;
+}
+
+// 获取单调时钟毫秒数
+static long get_time_ms(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+// 获取单调时钟微秒数
+static long long get_time_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000L;
+}
+
+// 分阶段耗时统计：每帧在读取、cache刷新、提交、结果回调、帧释放
+// 五个阶段的耗时进无锁直方图，SIGUSR1或退出时导出CSV。
+// 用于区分吞吐回退出在存储、刷新还是NPU上，不用再打printf补丁重编
+enum {
+	STAGE_READ = 0,   // 文件数据进DMA缓冲完成
+	STAGE_FLUSH,      // RK_MPI_SYS_MmzFlushCache完成
+	STAGE_PUSH,       // ROCKIVA_PushFrame返回
+	STAGE_RESULT,     // 提交返回到检测结果回调
+	STAGE_RELEASE,    // 结果回调到帧释放回调
+	STAGE_MAX,
+};
+
+static const char *g_stage_names[STAGE_MAX] = {
+	"read", "flush", "push", "result", "release",
+};
+
+// 桶i统计耗时在[2^i, 2^(i+1))微秒区间的帧数
+#define STAGE_HIST_BUCKETS 26
+static volatile RK_U64 g_stage_hist[STAGE_MAX][STAGE_HIST_BUCKETS];
+static volatile RK_U64 g_stage_sum_us[STAGE_MAX];
+static volatile RK_U64 g_stage_cnt[STAGE_MAX];
+// SIGUSR1置位，主线程轮询时导出（信号上下文里不能做文件IO）
+static volatile RK_S32 g_stage_dump_requested = 0;
+static const char *g_stage_stats_path = "stage_stats.csv";
+
+// SIGHUP置位，主线程轮询时执行模型热重载（见model_reload）
+static volatile RK_S32 g_reload_requested = 0;
+// 热重载暂停闸：置位后各提交线程停在暂停点不再推帧，
+// 在途帧全部释放后主线程才动IVA上下文
+static volatile RK_S32 g_reload_pause = 0;
+static volatile RK_S32 g_paused_senders = 0;
+// 仍在提交循环里的线程数；跑完的实例不再经过暂停点，不能再等它
+static volatile RK_S32 g_active_senders = 0;
+
+// 无锁记录一次阶段耗时（微秒）
+static void stage_record(int stage, long long us) {
+	int bucket = 0;
+	long long v = us;
+	if (us < 0)
+		return;
+	while (v > 1 && bucket < STAGE_HIST_BUCKETS - 1) {
+		v >>= 1;
+		bucket++;
+	}
+	__sync_fetch_and_add(&g_stage_hist[stage][bucket], 1);
+	__sync_fetch_and_add(&g_stage_sum_us[stage], (RK_U64)us);
+	__sync_fetch_and_add(&g_stage_cnt[stage], 1);
+}
+
+// 导出各阶段直方图为CSV：一行一个阶段，列为各2的幂次桶的计数
+// 稳态分配审计（--audit）：热路径的文件系统调用计数，加上流水线
+// 跑起来之后的堆占用基线快照。稳态零堆分配、零意外系统调用是
+// 帧时间可预测的前提——平均帧时间好看没用，抖动才是问题
+static RK_S32 g_audit_enable = 0;
+static volatile RK_U64 g_audit_file_syscalls = 0;
+static size_t g_audit_heap_baseline = 0;
+static RK_S32 g_audit_baseline_taken = 0;
+
+// 实时档（--realtime）丢帧总数，跨实例累计，随阶段统计一起导出
+static volatile RK_U64 g_frames_skipped_total = 0;
+
+// 结果早筛（--filter_types / --min_score）：扫描通常只关心少数类别和
+// 得分线以上的目标，低分杂项框却照样吃掉格式化与写盘开销，之后还要
+// 在analyze_detections.py里再筛一遍。早筛在回调里任何fprintf之前
+// 丢弃对象，被筛掉的数量随阶段统计一起导出
+static RK_U32 g_filter_type_mask = 0;  // 类别位掩码，0表示不按类别筛
+static RK_S32 g_min_score = 0;
+static volatile RK_U64 g_filter_suppressed = 0;
+// 单帧对象数上限按SDK结果数组取，通过位图的字数随之确定；
+// 对象数超过64时单字位图的移位会回绕串位，必须按字分段
+#define RESULT_MAX_OBJS \
+	((RK_S32)(sizeof(((RockIvaDetectResult *)0)->objInfo) / \
+	          sizeof(((RockIvaDetectResult *)0)->objInfo[0])))
+#define PASS_MASK_WORDS ((RESULT_MAX_OBJS + 63) / 64)
+
+// 内存水位记账：DMA/CMA消耗以前完全是黑盒，256MB的RV1106上把流水线
+// 深度拉高，CMA耗尽要等跑到一半GetMB失败才暴露。启动时读一次
+// /proc/meminfo的CmaFree做预检（见mem_preflight），按余量自动压低
+// 流水线深度；运行中记录帧池总字节、在途缓冲峰值、预载缓存占用，
+// 随阶段统计一起导出，外场按这几个数定深度不再靠猜
+static long long g_mem_cma_free_kb = -1;          // 预检时CmaFree，读不到为-1
+static volatile long long g_mem_pool_bytes = 0;   // 各实例帧池累计字节
+static volatile RK_U32 g_mem_inflight_peak = 0;   // 在途DMA缓冲峰值（帧数）
+static long long g_mem_preload_bytes = 0;         // 预载缓存实际占用字节
+
+// 从/proc/meminfo读CmaFree（kB）；内核未启用CMA统计时返回-1
+static long long mem_read_cma_free_kb(void) {
+	FILE *fp = fopen("/proc/meminfo", "r");
+	if (!fp)
+		return -1;
+	char line[128];
+	long long kb = -1;
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "CmaFree: %lld", &kb) == 1)
+			break;
+	}
+	fclose(fp);
+	return kb;
+}
+
+// 断点续跑（--resume）：主循环周期性把各实例已完成帧数和结果文件
+// 偏移写进<结果文件>.ckpt sidecar（先写.tmp再rename，替换是原子的），
+// 重启时裁掉结果文件的残尾并跳过已处理的帧。12小时扫描被断电/SIGKILL
+// 打断后，不再从第0帧白白重跑半天
+static RK_S32 g_resume_enable = 0;
+static char g_ckpt_path[512] = {0};
+#define CKPT_INTERVAL_S 5
+#define CKPT_MAX_INST 64
+static RK_S32 g_ckpt_loaded = 0;
+static long long g_ckpt_result_offset = 0;
+static RK_U32 g_ckpt_done[CKPT_MAX_INST];
+
+static void stage_stats_dump(void) {
+	FILE *fp = fopen(g_stage_stats_path, "w");
+	if (!fp) {
+		RK_LOGE("open %s failed because %s", g_stage_stats_path, strerror(errno));
+		return;
+	}
+
+	fprintf(fp, "stage,count,avg_us");
+	for (int b = 0; b < STAGE_HIST_BUCKETS; b++)
+		fprintf(fp, ",le_%dus", 1 << (b + 1));
+	fprintf(fp, "\n");
+
+	for (int s = 0; s < STAGE_MAX; s++) {
+		RK_U64 cnt = g_stage_cnt[s];
+		fprintf(fp, "%s,%llu,%llu", g_stage_names[s],
+		        (unsigned long long)cnt,
+		        (unsigned long long)(cnt ? g_stage_sum_us[s] / cnt : 0));
+		for (int b = 0; b < STAGE_HIST_BUCKETS; b++)
+			fprintf(fp, ",%llu", (unsigned long long)g_stage_hist[s][b]);
+		fprintf(fp, "\n");
+	}
+	// 热路径文件系统调用总数（open/read/pread/close等）
+	fprintf(fp, "file_syscalls,%llu,0\n", (unsigned long long)g_audit_file_syscalls);
+	// 实时档为追平时间轴丢掉的帧数
+	fprintf(fp, "frames_skipped,%llu,0\n", (unsigned long long)g_frames_skipped_total);
+	// 类别/得分早筛丢弃的对象数
+	fprintf(fp, "objs_suppressed,%llu,0\n", (unsigned long long)g_filter_suppressed);
+	// 内存水位：帧池总字节、在途缓冲峰值、预检时CMA余量、预载占用
+	fprintf(fp, "pool_bytes,%lld,0\n", g_mem_pool_bytes);
+	fprintf(fp, "inflight_peak_bufs,%u,0\n", g_mem_inflight_peak);
+	fprintf(fp, "cma_free_kb,%lld,0\n", g_mem_cma_free_kb);
+	fprintf(fp, "preload_bytes,%lld,0\n", g_mem_preload_bytes);
+	// 进程累计非自愿上下文切换（被抢占/迁移），绑核提权是否见效看这里
+	struct rusage ru;
+	if (getrusage(RUSAGE_SELF, &ru) == 0)
+		fprintf(fp, "involuntary_csw,%ld,0\n", ru.ru_nivcsw);
+	fclose(fp);
+	RK_LOGI("stage stats dumped to %s", g_stage_stats_path);
+}
+
+// 把聚合缓冲写入结果文件（调用方需持有g_result_file_mutex）。
+// 工作端模式结果不落本地盘，整段发回协调端合并
+static void result_bin_flush(void) {
+	if (g_result_bin_used > 0) {
+		if (g_worker_fd >= 0)
+			coord_send_result(g_result_bin_buf, g_result_bin_used);
+		else if (result_output_file)
+			fwrite(g_result_bin_buf, 1, g_result_bin_used, result_output_file);
+		g_result_bin_used = 0;
+	}
+	g_result_bin_last_flush_ms = get_time_ms();
+}
+
+// 是否使用mmap方式读取输入文件（--mmap），省掉每帧read()的系统调用开销
+static RK_S32 g_use_mmap_input = 0;
+
+// .yuvseq容器：定长NV12帧顺序拼接成单文件，头部记录尺寸和帧数
+// 目录模式每帧一个文件，50万帧的扫描会冲垮eMMC的FAT和dentry缓存，
+// 容器模式整个序列只做一次open()，每帧用pread()按偏移定位读取
+#define YUVSEQ_MAGIC 0x51455359  // "YSEQ"
+typedef struct {
+	RK_U32 magic;
+	RK_U32 version;
+	RK_U32 width;
+	RK_U32 height;
+	RK_U32 frame_count;
+	RK_U32 reserved[3];
+} YUVSEQ_HEADER_S;  // 固定32字节
+
+static RK_S32 g_yuvseq_fd = -1;       // 容器文件描述符，整个运行期间保持打开
+static RK_U32 g_yuvseq_frames = 0;    // 容器中的帧数
+// 打开容器时一次性预格式化好的"容器路径#帧号"名表，
+// 稳态路径不再做每帧snprintf
+static char **g_yuvseq_names = NULL;
+static char *g_yuvseq_name_arena = NULL;
+
+// 压缩视频输入（--video）：用VDEC硬解码h264/h265/mjpeg码流，
+// 解码帧直接拷入槽位DMA缓冲，硬解码与NPU推理在流水线上重叠。
+// 一段1小时640x360的回归视频按H.264只占约500MB，省掉
+// video_to_images.py预抽帧和上百GB的原始帧存储IO；码流到尾部后
+// 自动回绕循环播放，直到SIGINT或出错退出
+static char *g_video_path = NULL;
+static FILE *g_video_file = NULL;
+static RK_S32 g_vdec_chn = 0;
+static RK_S32 g_vdec_inited = 0;
+#define VDEC_CHUNK_SIZE (64 * 1024)
+
+// 流水线深度（DMA缓冲环槽位数），可通过--pipeline_depth配置
+// 读文件线程与IVA推理并行工作，深度大于1时文件IO和NPU推理相互重叠
+static RK_S32 g_pipeline_depth = 4;
+
+// 帧槽位：一块DMA缓冲以及当前装载帧的信息
+typedef struct {
+	MB_BLK blk;
+	void *vaddr;
+	RK_S32 fd;
+	char *src_path;  // 本槽位当前帧的来源文件
+	RK_U32 frame_id;
+	RK_S32 push_fd;  // 实际提交给IVA的fd：预载命中时指向缓存块，否则为本槽位fd
+	char seq_name[512];  // yuvseq模式下的"容器路径#帧号"描述
+} FRAME_SLOT_S;
+
+// 预载缓存（--preload）：启动时把整个目录一次性装进DMA缓存块，
+// 此后读线程直接推送缓存块的fd，稳态零磁盘IO；小数据集反复循环的
+// 回归套件由此从磁盘受限变成纯NPU基准，也免去长时间烤机对SD卡的磨损
+typedef struct {
+	MB_BLK blk;
+	void *vaddr;
+	RK_S32 fd;
+} PRELOAD_ENTRY_S;
+
+static RK_S32 g_preload_enable = 0;
+// 预载内存上限（--preload_mem，单位MB换算成字节），超限的文件回退磁盘读取
+static long long g_preload_mem_cap = 256LL * 1024 * 1024;
+static PRELOAD_ENTRY_S *g_preload_entries = NULL;
+static RK_S32 g_preload_count = 0;
+static RK_S32 g_preload_pool_id = -1;
+
+// 无锁单生产者/单消费者环形队列，传递槽位下标
+// 生产者只写wr、消费者只写rd，用原子内建保证跨线程可见性；
+// IVA释放回调经它归还槽位，不再走信号量，消除1-2ms的唤醒抖动
+typedef struct {
+	RK_U32 *entries;
+	RK_U32 cap_mask;  // 容量为2的幂，下标用掩码回绕
+	volatile RK_U32 wr;
+	volatile RK_U32 rd;
+} SPSC_RING_S;
+
+static RK_S32 spsc_init(SPSC_RING_S *ring, RK_U32 capacity) {
+	// 容量向上取2的幂
+	RK_U32 cap = 1;
+	while (cap < capacity)
+		cap <<= 1;
+	ring->entries = (RK_U32 *)calloc(cap, sizeof(RK_U32));
+	if (!ring->entries)
+		return RK_FAILURE;
+	ring->cap_mask = cap - 1;
+	ring->wr = 0;
+	ring->rd = 0;
+	return RK_SUCCESS;
+}
+
+static void spsc_deinit(SPSC_RING_S *ring) {
+	free(ring->entries);
+	ring->entries = NULL;
+}
+
+static RK_S32 spsc_push(SPSC_RING_S *ring, RK_U32 value) {
+	RK_U32 wr = __atomic_load_n(&ring->wr, __ATOMIC_RELAXED);
+	RK_U32 rd = __atomic_load_n(&ring->rd, __ATOMIC_ACQUIRE);
+	if (wr - rd > ring->cap_mask)
+		return RK_FAILURE;  // 满
+	ring->entries[wr & ring->cap_mask] = value;
+	__atomic_store_n(&ring->wr, wr + 1, __ATOMIC_RELEASE);
+	return RK_SUCCESS;
+}
+
+static RK_S32 spsc_pop(SPSC_RING_S *ring, RK_U32 *value) {
+	RK_U32 rd = __atomic_load_n(&ring->rd, __ATOMIC_RELAXED);
+	RK_U32 wr = __atomic_load_n(&ring->wr, __ATOMIC_ACQUIRE);
+	if (rd == wr)
+		return RK_FAILURE;  // 空
+	*value = ring->entries[rd & ring->cap_mask];
+	__atomic_store_n(&ring->rd, rd + 1, __ATOMIC_RELEASE);
+	return RK_SUCCESS;
+}
+
+// 先自旋再让出CPU的弹出，quit置位时返回失败
+static RK_S32 spsc_pop_spin(SPSC_RING_S *ring, RK_U32 *value) {
+	RK_U32 spins = 0;
+	while (!quit) {
+		if (spsc_pop(ring, value) == RK_SUCCESS)
+			return RK_SUCCESS;
+		if (++spins < 2000)
+			continue;
+		spins = 0;
+		sched_yield();
+	}
+	return RK_FAILURE;
+}
+
+// 带额外停止条件的自旋弹出：每轮先尝试弹出以排空环里的存量元素，
+// 生产者收工且环已空时返回失败，消费者不再无谓空等
+static RK_S32 spsc_pop_spin_stop(SPSC_RING_S *ring, RK_U32 *value,
+                                 volatile RK_S32 *stop) {
+	RK_U32 spins = 0;
+	while (!quit) {
+		if (spsc_pop(ring, value) == RK_SUCCESS)
+			return RK_SUCCESS;
+		if (*stop)
+			return RK_FAILURE;
+		if (++spins < 2000)
+			continue;
+		spins = 0;
+		sched_yield();
+	}
+	return RK_FAILURE;
+}
+
+// IVA实例：多实例模式（--instances）下每个实例拥有独立的IVA上下文、
+// DMA缓冲环和收发线程，文件列表按实例分片以吃满多核NPU
+typedef struct {
+	RK_S32 inst_id;
+	SAMPLE_IVA_CTX_S iva_ctx;  // 必须放在首位，回调userdata反查依赖该布局
+
+	// 流水线缓冲环
+	FRAME_SLOT_S *slots;
+	RK_S32 pool_id;
+	// 前处理暂存缓冲：原始分辨率帧先落这里再缩放/裁剪进DMA槽位
+	RK_U8 *pre_buf;
+	SPSC_RING_S recycle_ring;  // 释放回调→读线程：归还的空闲槽位下标
+	SPSC_RING_S filled_ring;   // 读线程→提交线程：已装载槽位下标
+	RK_U32 release_seq;        // 已释放帧序号，按提交顺序映射回槽位
+
+	// 帧提交/释放计数，用于退出前等待在途帧全部释放
+	volatile RK_U32 frames_pushed;
+	volatile RK_U32 frames_released;
+
+	// 已提交帧的来源文件与帧号FIFO，结果回调按提交顺序取用
+	// （流水线模式下读游标已领先多帧，不能再用它反推当前帧）
+	char **inflight_paths;
+	RK_U32 *inflight_frame_ids;
+	RK_U32 inflight_cap;
+	volatile RK_U32 inflight_wr;
+	volatile RK_U32 inflight_rd;
+
+	// 本实例负责的文件/帧分片[file_begin, file_end)及循环次数
+	RK_S32 file_begin;
+	RK_S32 file_end;
+	RK_S32 file_cursor;
+	RK_S32 loop_count;
+
+	// 基准/分阶段统计：提交时间戳环（与在途FIFO同步推进）、
+	// 每帧提交到结果回调的延迟样本、起止时间
+	long long *inflight_push_us;
+	volatile long long last_result_us;
+	long *lat_samples;
+	RK_U32 lat_count;
+	RK_U32 lat_cap;
+	long bench_start_ms;
+	long last_result_ms;
+	volatile RK_U32 results_received;
+
+	pthread_t send_thread_id;
+	pthread_t read_thread_id;
+
+	// 目录模式预读：读线程已消费的文件数与预读线程停止标志
+	volatile RK_U32 files_read;
+	volatile RK_S32 readahead_stop;
+	pthread_t readahead_thread_id;
+
+	// 回调线程是否已就地绑核/提权（IVA库内部线程，首次回调时设置）
+	volatile RK_S32 cb_tuned;
+	volatile RK_S32 release_cb_tuned;
+
+	// 实时档：提交线程发出的待跳帧数与读线程已跳过的帧数
+	volatile RK_S32 skip_request;
+	volatile RK_U32 frames_skipped;
+	// 读线程已退出（实时跳帧会提前耗尽循环额度，提交线程据此停等）
+	volatile RK_S32 reader_done;
+
+	// 本实例是否自然跑完（区别于被quit打断，决定断点文件去留）
+	volatile RK_S32 run_complete;
+} IVA_INSTANCE_S;
+
+// 实例数量（--instances）与实例数组
+static RK_S32 g_instance_count = 1;
+static IVA_INSTANCE_S *g_instances = NULL;
+// 多实例共用一个结果文件，写入时用互斥锁串行化
+static pthread_mutex_t g_result_file_mutex = PTHREAD_MUTEX_INITIALIZER;
+// 已完成的实例数，全部完成后才触发正常退出
+static volatile RK_S32 g_instances_done = 0;
+
+// 基准模式（--benchmark）：关闭detectrate限速，让流水线满速提交，
+// 结束时按提交到结果回调的耗时统计fps和p50/p95/p99延迟
+static RK_S32 g_benchmark_mode = 0;
+
+// 批量提交（--batch K）：连续推K帧再统一限速一次，让NPU命令队列
+// 保持非空，消除逐帧提交间隙里的NPU空闲时间
+static RK_S32 g_batch_size = 1;
+
+// 目录模式预读深度（--readahead N，0关闭）：预读线程在读文件线程
+// 前方N个文件发posix_fadvise(WILLNEED)，冷文件提前进page cache
+static RK_S32 g_readahead_depth = 2;
+
+// 实时档（--realtime）：提交线程跟踪单帧耗时的EWMA，NPU过热降频
+// 跟不上额定帧率时向读线程发跳帧请求，游标沿文件列表前跳追平时间轴。
+// 真实相机在后端过载时就是直接丢帧，而不是把时间轴越拖越长
+static RK_S32 g_realtime_mode = 0;
+
+// 线程绑核与实时调度（--affinity / --sched_fifo）：流水线线程默认随
+// 调度器在核间迁移，繁忙的RV1106上迁移和普通任务抢占会造成周期性的
+// 5~10ms延迟毛刺。绑核后提交/读文件/预读线程各守一个核，SCHED_FIFO
+// 再把它们抬到普通负载之上。结果回调线程由IVA库内部创建，无法在
+// 创建时设属性，改为首次回调时在线程自身上就地设置
+#define AFFINITY_MAX_CORES 16
+static RK_S32 g_affinity_cores[AFFINITY_MAX_CORES];
+static RK_S32 g_affinity_core_count = 0;
+static RK_S32 g_sched_fifo_prio = 0;
+
+// 把当前线程按实例号钉到核列表中的一个核，并按需切到SCHED_FIFO
+static void pipeline_thread_tune(RK_S32 inst_id) {
+	int err;
+	if (g_affinity_core_count > 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(g_affinity_cores[inst_id % g_affinity_core_count], &set);
+		err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+		if (err != 0)
+			RK_LOGE("set affinity for inst %d failed because %s", inst_id,
+			        strerror(err));
+	}
+	if (g_sched_fifo_prio > 0) {
+		struct sched_param sp;
+		memset(&sp, 0, sizeof(sp));
+		sp.sched_priority = g_sched_fifo_prio;
+		err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+		if (err != 0)
+			RK_LOGE("set SCHED_FIFO %d for inst %d failed because %s",
+			        g_sched_fifo_prio, inst_id, strerror(err));
+	}
+}
+
+// 任务清单模式（--jobs）：清单每行"目录 宽 高 帧率 结果文件"，在一个
+// 进程里顺序执行。MPI系统整个进程只初始化一次；相邻任务分辨率相同时
+// IVA上下文和MB内存池也跨任务保留，省掉每个任务约2秒的模型重载。
+// 6种分辨率×40套语料的夜间矩阵由此省下约10分钟纯启动开销
+static char *g_jobs_path = NULL;
+// 当前任务结束后是否把IVA上下文/内存池留给下一个任务
+static RK_S32 g_job_keep_ctx = 0;
+
+// 任务清单条目
+typedef struct {
+	char dir[256];
+	RK_U32 width;
+	RK_U32 height;
+	RK_U32 rate;
+	char output[256];
+} JOB_ENTRY_S;
+
+// 模型热缓存（--model_cache）：把模型文件复制进/dev/shm共享内存并
+// mlock常驻，shm对象跨进程重启存活。看门狗频繁重启现场进程时，
+// SAMPLE_COMM_IVA_Create不再从存储介质冷读几十MB模型文件，
+// 首帧出结果时间是客户可见指标
+static RK_S32 g_model_cache_enable = 0;
+static void *g_model_cache_map = NULL;
+static size_t g_model_cache_size = 0;
+// 启用缓存前的原始模型目录，热重载重灌缓存时要从这里再读源文件
+static RK_CHAR *g_model_cache_src_dir = NULL;
+
+// 建立或复用共享内存中的模型缓存，并把模型目录指向/dev/shm
+static RK_S32 model_cache_init(void) {
+	char src_path[512];
+	struct stat src_st;
+	struct stat shm_st;
+
+	snprintf(src_path, sizeof(src_path), "%s/%s", pIvaModelPath, pIvaModelName);
+	if (stat(src_path, &src_st) < 0) {
+		RK_LOGE("stat model %s failed because %s", src_path, strerror(errno));
+		return RK_FAILURE;
+	}
+
+	// shm对象名直接用模型文件名，在/dev/shm下可见便于排查
+	RK_S32 fd = shm_open(pIvaModelName, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		RK_LOGE("shm_open %s failed because %s", pIvaModelName, strerror(errno));
+		return RK_FAILURE;
+	}
+
+	// 尺寸一致且shm对象mtime等于源文件mtime才算热缓存。冷灌完会把
+	// 源文件的mtime盖到shm对象上，重新训练的模型尺寸往往不变（结构
+	// 没动），光比尺寸会把旧权重当缓存继续用
+	if (fstat(fd, &shm_st) == 0 && shm_st.st_size == src_st.st_size &&
+	    shm_st.st_mtim.tv_sec == src_st.st_mtim.tv_sec &&
+	    shm_st.st_mtim.tv_nsec == src_st.st_mtim.tv_nsec) {
+		RK_LOGI("model cache warm: %s already resident (%lld bytes)",
+		        pIvaModelName, (long long)src_st.st_size);
+	} else {
+		if (ftruncate(fd, src_st.st_size) < 0) {
+			RK_LOGE("ftruncate model cache failed because %s", strerror(errno));
+			close(fd);
+			return RK_FAILURE;
+		}
+		RK_S32 src_fd = open(src_path, O_RDONLY);
+		if (src_fd < 0) {
+			RK_LOGE("open %s failed because %s", src_path, strerror(errno));
+			close(fd);
+			return RK_FAILURE;
+		}
+		void *dst = mmap(NULL, src_st.st_size, PROT_WRITE, MAP_SHARED, fd, 0);
+		if (dst == MAP_FAILED) {
+			RK_LOGE("mmap model cache failed because %s", strerror(errno));
+			close(src_fd);
+			close(fd);
+			return RK_FAILURE;
+		}
+		RK_U8 *wr = (RK_U8 *)dst;
+		off_t left = src_st.st_size;
+		while (left > 0) {
+			RK_S32 n = read(src_fd, wr, left);
+			if (n <= 0)
+				break;
+			wr += n;
+			left -= n;
+		}
+		munmap(dst, src_st.st_size);
+		close(src_fd);
+		if (left > 0) {
+			RK_LOGE("read model %s incomplete, %lld bytes left", src_path,
+			        (long long)left);
+			close(fd);
+			return RK_FAILURE;
+		}
+		// 灌完才盖mtime（写映射已munmap，不会再弄脏），半截缓存对不上
+		// mtime，下次启动会重灌
+		struct timespec stamp[2] = {src_st.st_mtim, src_st.st_mtim};
+		if (futimens(fd, stamp) < 0)
+			RK_LOGE("stamp model cache mtime failed because %s", strerror(errno));
+		RK_LOGI("model cache cold fill: %s -> /dev/shm/%s (%lld bytes)",
+		        src_path, pIvaModelName, (long long)src_st.st_size);
+	}
+
+	// 映射并mlock，防止内存紧张时缓存页被回收、热启动变回冷启动
+	g_model_cache_map = mmap(NULL, src_st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (g_model_cache_map == MAP_FAILED) {
+		g_model_cache_map = NULL;
+		RK_LOGE("mmap model cache failed because %s", strerror(errno));
+		return RK_FAILURE;
+	}
+	g_model_cache_size = (size_t)src_st.st_size;
+	if (mlock(g_model_cache_map, g_model_cache_size) < 0)
+		RK_LOGE("mlock model cache failed because %s", strerror(errno));
+
+	// Create按"目录+文件名"找模型，指到/dev/shm即可消费缓存副本
+	g_model_cache_src_dir = pIvaModelPath;
+	pIvaModelPath = "/dev/shm/";
+	return RK_SUCCESS;
+}
+
+// 解除本进程的映射；特意不shm_unlink，缓存留给下一次进程启动
+static void model_cache_deinit(void) {
+	if (g_model_cache_map) {
+		munlock(g_model_cache_map, g_model_cache_size);
+		munmap(g_model_cache_map, g_model_cache_size);
+		g_model_cache_map = NULL;
+		g_model_cache_size = 0;
+	}
+}
+
+// 共享内存结果总线（--shm_publish）：结果回调把每帧检测结果无锁写进
+// /dev/shm里的定长记录环，本机消费者mmap后轮询读取，零系统调用。
+// 现场的告警链路原来靠tail结果文件再解析文本，相机到告警的延迟被
+// fflush+inotify+解析往返吃掉大半，走共享内存后这段开销整个消失。
+// 写协议：fetch_add占一个写序号，先把记录序号置为占位值，填完负载
+// 再写回真实序号（序号=写序号+1）；读方拷走记录后复核序号未变且
+// 匹配，即可确认没被环回绕覆盖。头部的writer_seq就是最新进度
+#define SHM_RESULT_NAME "/xsense_npu_results"
+#define SHM_RESULT_SLOTS 64
+#define SHM_RING_MAGIC 0x52525358  // "XSRR"
+
+// 记录环头部，后面紧跟SHM_RESULT_SLOTS条定长记录
+typedef struct {
+	RK_U32 magic;
+	RK_U32 version;
+	RK_U32 slot_count;
+	RK_U32 rec_size;
+	volatile RK_U64 writer_seq;  // 已占用的写序号总数
+	RK_U32 reserved[6];
+} SHM_RING_HEADER_S;
+
+// 单条结果记录：序号最后写入，(RK_U64)-1表示正在填充
+typedef struct {
+	volatile RK_U64 seq;
+	long long publish_us;
+	char src_path[256];
+	RockIvaDetectResult result;
+} SHM_RESULT_REC_S;
+
+static RK_S32 g_shm_publish_enable = 0;
+static SHM_RING_HEADER_S *g_shm_ring = NULL;
+static SHM_RESULT_REC_S *g_shm_recs = NULL;
+
+// 建立共享内存记录环并初始化头部
+static RK_S32 shm_publish_init(void) {
+	size_t total = sizeof(SHM_RING_HEADER_S) +
+	               (size_t)SHM_RESULT_SLOTS * sizeof(SHM_RESULT_REC_S);
+
+	RK_S32 fd = shm_open(SHM_RESULT_NAME, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		RK_LOGE("shm_open %s failed because %s", SHM_RESULT_NAME, strerror(errno));
+		return RK_FAILURE;
+	}
+	if (ftruncate(fd, total) < 0) {
+		RK_LOGE("ftruncate %s failed because %s", SHM_RESULT_NAME, strerror(errno));
+		close(fd);
+		return RK_FAILURE;
+	}
+	void *map = mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		RK_LOGE("mmap %s failed because %s", SHM_RESULT_NAME, strerror(errno));
+		return RK_FAILURE;
+	}
+
+	g_shm_ring = (SHM_RING_HEADER_S *)map;
+	g_shm_recs = (SHM_RESULT_REC_S *)((char *)map + sizeof(SHM_RING_HEADER_S));
+	// 重建环：残留的旧记录对消费者无意义，全部清掉从0开始
+	memset(map, 0, total);
+	g_shm_ring->magic = SHM_RING_MAGIC;
+	g_shm_ring->version = 1;
+	g_shm_ring->slot_count = SHM_RESULT_SLOTS;
+	g_shm_ring->rec_size = sizeof(SHM_RESULT_REC_S);
+	RK_LOGI("result bus ready at %s (%d slots of %u bytes)", SHM_RESULT_NAME,
+	        SHM_RESULT_SLOTS, g_shm_ring->rec_size);
+	return RK_SUCCESS;
+}
+
+// 解除映射；shm对象特意不unlink，消费者可以继续读完最后一批记录
+static void shm_publish_deinit(void) {
+	if (g_shm_ring) {
+		size_t total = sizeof(SHM_RING_HEADER_S) +
+		               (size_t)SHM_RESULT_SLOTS * sizeof(SHM_RESULT_REC_S);
+		munmap(g_shm_ring, total);
+		g_shm_ring = NULL;
+		g_shm_recs = NULL;
+	}
+}
+
+// 把一帧结果发布进记录环（多实例回调并发安全，序号占位见上）
+static void shm_publish_record(const char *src_path,
+                               const RockIvaDetectResult *result) {
+	RK_U64 idx = __sync_fetch_and_add(&g_shm_ring->writer_seq, 1);
+	SHM_RESULT_REC_S *rec = &g_shm_recs[idx % SHM_RESULT_SLOTS];
+
+	rec->seq = (RK_U64)-1;
+	__sync_synchronize();
+	rec->publish_us = get_time_us();
+	if (src_path) {
+		strncpy(rec->src_path, src_path, sizeof(rec->src_path) - 1);
+		rec->src_path[sizeof(rec->src_path) - 1] = '\0';
+	} else {
+		rec->src_path[0] = '\0';
+	}
+	memcpy(&rec->result, result, sizeof(RockIvaDetectResult));
+	__sync_synchronize();
+	rec->seq = idx + 1;
+}
+
+// 检测子窗口（--roi x,y,w,h）：固定机位画面里有效区域往往只占一小块，
+// 缩小检测窗口等比例降低每帧NPU工作量。w/h为0表示全幅
+static RK_S32 g_roi_x = 0;
+static RK_S32 g_roi_y = 0;
+static RK_S32 g_roi_w = 0;
+static RK_S32 g_roi_h = 0;
+
+// 逐文件ROI清单（--roi_file，目录模式）：每行"文件名 x y w h"。
+// 检测窗口在创建IVA实例时就固定了，没法逐帧改，所以清单ROI退一步
+// 作用在结果侧：中心点落在该文件ROI之外的目标在写结果前被丢弃。
+// 坐标与结果矩形同一坐标系
+typedef struct {
+	char name[256];
+	RK_S32 x;
+	RK_S32 y;
+	RK_S32 w;
+	RK_S32 h;
+} ROI_ENTRY_S;
+static ROI_ENTRY_S *g_roi_entries = NULL;
+static RK_S32 g_roi_entry_count = 0;
+static char *g_roi_file_path = NULL;
+
+// 读入逐文件ROI清单
+static RK_S32 roi_file_load(const char *manifest_path) {
+	FILE *fp = fopen(manifest_path, "r");
+	if (!fp) {
+		RK_LOGE("open roi file %s failed because %s", manifest_path, strerror(errno));
+		return RK_FAILURE;
+	}
+
+	RK_S32 cap = 64;
+	g_roi_entries = (ROI_ENTRY_S *)malloc(cap * sizeof(ROI_ENTRY_S));
+	if (!g_roi_entries) {
+		fclose(fp);
+		return RK_FAILURE;
+	}
+
+	char line[512];
+	while (fgets(line, sizeof(line), fp)) {
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		if (g_roi_entry_count >= cap) {
+			cap *= 2;
+			ROI_ENTRY_S *grown = (ROI_ENTRY_S *)realloc(g_roi_entries,
+			                                            cap * sizeof(ROI_ENTRY_S));
+			if (!grown)
+				break;
+			g_roi_entries = grown;
+		}
+		ROI_ENTRY_S *e = &g_roi_entries[g_roi_entry_count];
+		if (sscanf(line, "%255s %d %d %d %d", e->name, &e->x, &e->y, &e->w, &e->h) == 5)
+			g_roi_entry_count++;
+	}
+	fclose(fp);
+	RK_LOGI("roi file %s loaded, %d entries", manifest_path, g_roi_entry_count);
+	return RK_SUCCESS;
+}
+
+// 按basename匹配当前帧来源文件对应的ROI条目
+static const ROI_ENTRY_S *roi_lookup(const char *current_file) {
+	if (!current_file || g_roi_entry_count == 0)
+		return NULL;
+	const char *base = strrchr(current_file, '/');
+	base = base ? base + 1 : current_file;
+	for (RK_S32 n = 0; n < g_roi_entry_count; n++) {
+		if (strcmp(g_roi_entries[n].name, base) == 0)
+			return &g_roi_entries[n];
+	}
+	return NULL;
+}
+
+// 目标中心点是否落在ROI内
+static RK_S32 roi_obj_pass(const ROI_ENTRY_S *e, RK_S32 left, RK_S32 top,
+                           RK_S32 right, RK_S32 bottom) {
+	RK_S32 cx = (left + right) / 2;
+	RK_S32 cy = (top + bottom) / 2;
+	return cx >= e->x && cx < e->x + e->w && cy >= e->y && cy < e->y + e->h;
+}
+
+// 对象是否通过早筛与ROI；每个对象只调用一次，被筛掉的计入统计
+static RK_S32 result_obj_pass(const ROI_ENTRY_S *roi,
+                              const RockIvaObjectInfo *obj) {
+	if (g_filter_type_mask || g_min_score > 0) {
+		if ((g_filter_type_mask &&
+		     (obj->type < 0 || obj->type >= 32 ||
+		      !(g_filter_type_mask & (1u << obj->type)))) ||
+		    (g_min_score > 0 && obj->score < g_min_score)) {
+			__sync_fetch_and_add(&g_filter_suppressed, 1);
+			return 0;
+		}
+	}
+	if (roi && !roi_obj_pass(roi, obj->rect.topLeft.x, obj->rect.topLeft.y,
+	                         obj->rect.bottomRight.x, obj->rect.bottomRight.y))
+		return 0;
+	return 1;
+}
+
+// 在线结果分析（--analyze）：结果回调内联维护得分直方图、类型计数
+// 和分得分区间的文件清单，内存占用O(1)。跑完即出分析结果，
+// 替代analyze_detections.py对几GB结果文本的二次全量正则扫描
+static RK_S32 g_analyze_enable = 0;
+#define ANALYZE_SCORE_BINS 10
+#define ANALYZE_TYPE_MAX 16
+static pthread_mutex_t g_analyze_mutex = PTHREAD_MUTEX_INITIALIZER;
+static RK_U64 g_analyze_score_hist[ANALYZE_SCORE_BINS];
+static RK_U64 g_analyze_type_cnt[ANALYZE_TYPE_MAX];
+static RK_U64 g_analyze_frames = 0;
+static RK_U64 g_analyze_detected_frames = 0;
+static RK_U64 g_analyze_objects = 0;
+static RK_U64 g_analyze_score_sum = 0;
+static RK_S32 g_analyze_score_min = -1;
+static RK_S32 g_analyze_score_max = 0;
+// 各得分区间的清单文件：先写.part临时名，结束时改名带上最终计数，
+// 和analyze_detections.py的输出命名保持一致
+static FILE *g_analyze_range_files[ANALYZE_SCORE_BINS];
+static FILE *g_analyze_nodet_file = NULL;
+static RK_U64 g_analyze_nodet_count = 0;
+static char g_analyze_base[256] = "analyze";
+
+// 打开各得分区间的清单文件
+static RK_S32 analyze_init(void) {
+	char name[320];
+
+	// 用结果文件路径（去掉_result.txt后缀）作为清单文件前缀
+	if (result_output_path) {
+		snprintf(g_analyze_base, sizeof(g_analyze_base), "%s", result_output_path);
+		char *suffix = strstr(g_analyze_base, "_result.txt");
+		if (suffix)
+			*suffix = '\0';
+	}
+
+	for (int b = 0; b < ANALYZE_SCORE_BINS; b++) {
+		snprintf(name, sizeof(name), "%s_files_scores%02d-%02d.part",
+		         g_analyze_base, b * 10, (b + 1) * 10);
+		g_analyze_range_files[b] = fopen(name, "w");
+		if (!g_analyze_range_files[b]) {
+			RK_LOGE("open %s failed because %s", name, strerror(errno));
+			return RK_FAILURE;
+		}
+	}
+	snprintf(name, sizeof(name), "%s_files_no_detections.part", g_analyze_base);
+	g_analyze_nodet_file = fopen(name, "w");
+	if (!g_analyze_nodet_file) {
+		RK_LOGE("open %s failed because %s", name, strerror(errno));
+		return RK_FAILURE;
+	}
+	return RK_SUCCESS;
+}
+
+// 回调内联分析一帧结果：更新直方图/计数并把文件名追加到对应区间清单
+static void analyze_record(const char *current_file, const RockIvaDetectResult *result) {
+	pthread_mutex_lock(&g_analyze_mutex);
+	g_analyze_frames++;
+
+	if (result->objNum > 0) {
+		g_analyze_detected_frames++;
+		g_analyze_objects += result->objNum;
+		for (int i = 0; i < result->objNum; i++) {
+			RK_S32 type = result->objInfo[i].type;
+			if (type >= 0 && type < ANALYZE_TYPE_MAX)
+				g_analyze_type_cnt[type]++;
+		}
+
+		// 与脚本口径一致：每帧取第一个对象的得分
+		RK_S32 score = result->objInfo[0].score;
+		int bin = score / 10;
+		if (bin < 0)
+			bin = 0;
+		if (bin >= ANALYZE_SCORE_BINS)
+			bin = ANALYZE_SCORE_BINS - 1;
+		g_analyze_score_hist[bin]++;
+		g_analyze_score_sum += score;
+		if (g_analyze_score_min < 0 || score < g_analyze_score_min)
+			g_analyze_score_min = score;
+		if (score > g_analyze_score_max)
+			g_analyze_score_max = score;
+		if (current_file && g_analyze_range_files[bin])
+			fprintf(g_analyze_range_files[bin], "%s score:%d\n", current_file, score);
+	} else {
+		// 未检出的帧计入0-10区间（与脚本的score=0口径一致）
+		g_analyze_score_hist[0]++;
+		g_analyze_nodet_count++;
+		if (current_file) {
+			if (g_analyze_range_files[0])
+				fprintf(g_analyze_range_files[0], "%s score:0\n", current_file);
+			if (g_analyze_nodet_file)
+				fprintf(g_analyze_nodet_file, "%s\n", current_file);
+		}
+	}
+	pthread_mutex_unlock(&g_analyze_mutex);
+}
+
+// 收尾：清单文件改名带上最终计数，打印汇总统计
+static void analyze_finish(void) {
+	char part_name[320];
+	char final_name[384];
+
+	for (int b = 0; b < ANALYZE_SCORE_BINS; b++) {
+		if (!g_analyze_range_files[b])
+			continue;
+		fclose(g_analyze_range_files[b]);
+		g_analyze_range_files[b] = NULL;
+		snprintf(part_name, sizeof(part_name), "%s_files_scores%02d-%02d.part",
+		         g_analyze_base, b * 10, (b + 1) * 10);
+		snprintf(final_name, sizeof(final_name), "%s_files_scores%02d-%02d_cnt-%llu.txt",
+		         g_analyze_base, b * 10, (b + 1) * 10,
+		         (unsigned long long)g_analyze_score_hist[b]);
+		rename(part_name, final_name);
+	}
+	if (g_analyze_nodet_file) {
+		fclose(g_analyze_nodet_file);
+		g_analyze_nodet_file = NULL;
+		snprintf(part_name, sizeof(part_name), "%s_files_no_detections.part",
+		         g_analyze_base);
+		snprintf(final_name, sizeof(final_name), "%s_files_no_detections_total-%llu.txt",
+		         g_analyze_base, (unsigned long long)g_analyze_nodet_count);
+		rename(part_name, final_name);
+	}
+
+	printf("analyze: %llu frames, %llu detected (rate %.2f), %llu objects\n",
+	       (unsigned long long)g_analyze_frames,
+	       (unsigned long long)g_analyze_detected_frames,
+	       g_analyze_frames ? (double)g_analyze_detected_frames / g_analyze_frames : 0.0,
+	       (unsigned long long)g_analyze_objects);
+	if (g_analyze_detected_frames > 0)
+		printf("analyze: score avg %.2f, min %d, max %d\n",
+		       (double)g_analyze_score_sum / g_analyze_detected_frames,
+		       g_analyze_score_min, g_analyze_score_max);
+	for (int b = 0; b < ANALYZE_SCORE_BINS; b++)
+		printf("analyze: score %2d-%2d: %llu\n", b * 10, (b + 1) * 10,
+		       (unsigned long long)g_analyze_score_hist[b]);
+	for (int t = 0; t < ANALYZE_TYPE_MAX; t++) {
+		if (g_analyze_type_cnt[t])
+			printf("analyze: type %d: %llu objects\n", t,
+			       (unsigned long long)g_analyze_type_cnt[t]);
+	}
+}
+
+// 从回调userdata反查所属实例。sample_comm注册回调时携带的是
+// SAMPLE_IVA_CTX_S指针；老版本可能传NULL，此时退回实例0
+static IVA_INSTANCE_S *instance_from_userdata(void *userdata) {
+	for (RK_S32 k = 0; k < g_instance_count; k++) {
+		if (userdata == (void *)&g_instances[k].iva_ctx)
+			return &g_instances[k];
+	}
+	return &g_instances[0];
+}
+
+// SIGINT单独记下来：任务队列模式据此区分"用户要求停"和"单个任务跑完"
+static volatile RK_S32 g_got_sigint = 0;
+
+// 退出事件fd：主线程不再sleep(1)轮询quit，而是poll这个fd等唤醒。
+// 信号处理函数和线程错误路径都要能叫醒主线程，write是
+// async-signal-safe的而pthread_cond_signal不是，所以用eventfd。
+// 调度器一晚拉起几百个短任务时，每次退出省下的那一秒很可观
+static RK_S32 g_quit_evtfd = -1;
+
+// 叫醒正在poll退出事件的主线程（信号上下文可安全调用）
+static void quit_wakeup(void) {
+	if (g_quit_evtfd >= 0) {
+		RK_U64 one = 1;
+		ssize_t n = write(g_quit_evtfd, &one, sizeof(one));
+		(void)n;
+	}
+}
+
+// 清掉事件fd里积累的计数，任务队列模式下一个任务复用同一个fd
+static void quit_evtfd_drain(void) {
+	if (g_quit_evtfd >= 0) {
+		RK_U64 cnt;
+		while (read(g_quit_evtfd, &cnt, sizeof(cnt)) == (ssize_t)sizeof(cnt))
+			;
+	}
+}
+
 static void sigterm_handler(int sig) {
 	fprintf(stderr, "signal %d\n", sig);
 	quit = true;
 	quit_result = RK_SUCCESS;
+	g_got_sigint = 1;
+	quit_wakeup();
+}
+
+// SIGUSR1请求导出分阶段统计；信号上下文只置标志，主线程完成落盘
+static void sigusr1_handler(int sig) {
+	g_stage_dump_requested = 1;
+	quit_wakeup();
+}
+
+// SIGHUP请求模型热重载；同样只置标志，重载动作在主线程安全执行
+static void sighup_handler(int sig) {
+	g_reload_requested = 1;
+	quit_wakeup();
 }
 
 static void program_handle_error(const char *func, RK_U32 line) {
 	printf("func: <%s> line: <%d> error exit!", func, line);
 	quit = true;
 	quit_result = RK_FAILURE;
+	quit_wakeup();
 }
 
 static void program_normal_exit(const char *func, RK_U32 line) {
 	printf("func: <%s> line: <%d> normal exit!", func, line);
 	quit = true;
 	quit_result = RK_SUCCESS;
+	quit_wakeup();
 }
 
 // 修改命令行参数，移除loop_count选项
 static RK_CHAR optstr[] = "?:w:h:p:d:r:e:s:o:t:n:l:";
+
+// 短选项字母已基本用完，新增的长选项统一使用256以上的取值
+enum {
+	OPT_PIPELINE_DEPTH = 256,
+	OPT_MMAP_INPUT,
+	OPT_INSTANCES,
+	OPT_RESULT_FORMAT,
+	OPT_BENCHMARK,
+	OPT_PRELOAD,
+	OPT_PRELOAD_MEM,
+	OPT_BATCH,
+	OPT_VIDEO,
+	OPT_ANALYZE,
+	OPT_READAHEAD,
+	OPT_AUDIT,
+	OPT_RESUME,
+	OPT_ROI,
+	OPT_ROI_FILE,
+	OPT_JOBS,
+	OPT_MODEL_CACHE,
+	OPT_REALTIME,
+	OPT_SHM_PUBLISH,
+	OPT_AFFINITY,
+	OPT_SCHED_FIFO,
+	OPT_INPUT_SIZE,
+	OPT_PREPROCESS,
+	OPT_STDIN,
+	OPT_SOCKET,
+	OPT_BENCH_SUITE,
+	OPT_GOLDEN,
+	OPT_FILTER_TYPES,
+	OPT_MIN_SCORE,
+	OPT_COORDINATOR,
+	OPT_WORKER,
+};
+
 static const struct option long_options[] = {
     {"path", required_argument, NULL, 'p'},
     {"directory", required_argument, NULL, 'd'},
@@ -97,6 +1283,60 @@ static const struct option long_options[] = {
     {"detectrate", optional_argument, NULL, 't'},
     // 添加结果输出文件选项
     {"result_output", required_argument, NULL, 'o'},
+    // 添加流水线深度选项
+    {"pipeline_depth", required_argument, NULL, OPT_PIPELINE_DEPTH},
+    // 添加mmap输入模式选项
+    {"mmap", no_argument, NULL, OPT_MMAP_INPUT},
+    // 添加多实例并行选项
+    {"instances", required_argument, NULL, OPT_INSTANCES},
+    // 添加结果输出格式选项
+    {"result_format", required_argument, NULL, OPT_RESULT_FORMAT},
+    // 添加基准测试模式选项
+    {"benchmark", no_argument, NULL, OPT_BENCHMARK},
+    // 添加预载缓存选项
+    {"preload", no_argument, NULL, OPT_PRELOAD},
+    {"preload_mem", required_argument, NULL, OPT_PRELOAD_MEM},
+    // 添加批量提交选项
+    {"batch", required_argument, NULL, OPT_BATCH},
+    // 添加压缩视频输入选项
+    {"video", required_argument, NULL, OPT_VIDEO},
+    // 添加在线结果分析选项
+    {"analyze", no_argument, NULL, OPT_ANALYZE},
+    // 添加目录预读深度选项
+    {"readahead", required_argument, NULL, OPT_READAHEAD},
+    // 添加稳态分配审计选项
+    {"audit", no_argument, NULL, OPT_AUDIT},
+    // 添加断点续跑选项
+    {"resume", no_argument, NULL, OPT_RESUME},
+    // 添加检测子窗口选项
+    {"roi", required_argument, NULL, OPT_ROI},
+    {"roi_file", required_argument, NULL, OPT_ROI_FILE},
+    // 添加任务清单选项
+    {"jobs", required_argument, NULL, OPT_JOBS},
+    // 添加模型热缓存选项
+    {"model_cache", no_argument, NULL, OPT_MODEL_CACHE},
+    // 添加实时档选项
+    {"realtime", no_argument, NULL, OPT_REALTIME},
+    // 添加共享内存结果总线选项
+    {"shm_publish", no_argument, NULL, OPT_SHM_PUBLISH},
+    // 添加线程绑核与实时调度选项
+    {"affinity", required_argument, NULL, OPT_AFFINITY},
+    {"sched_fifo", required_argument, NULL, OPT_SCHED_FIFO},
+    // 添加NV12前处理选项
+    {"input_size", required_argument, NULL, OPT_INPUT_SIZE},
+    {"preprocess", required_argument, NULL, OPT_PREPROCESS},
+    // 添加流式输入选项
+    {"stdin", no_argument, NULL, OPT_STDIN},
+    {"socket", required_argument, NULL, OPT_SOCKET},
+    // 添加基准套件选项
+    {"bench_suite", required_argument, NULL, OPT_BENCH_SUITE},
+    {"golden", required_argument, NULL, OPT_GOLDEN},
+    // 添加结果早筛选项
+    {"filter_types", required_argument, NULL, OPT_FILTER_TYPES},
+    {"min_score", required_argument, NULL, OPT_MIN_SCORE},
+    // 添加协调/工作端模式选项
+    {"coordinator", required_argument, NULL, OPT_COORDINATOR},
+    {"worker", required_argument, NULL, OPT_WORKER},
     {"help", optional_argument, NULL, '?'},
     {NULL, 0, NULL, 0},
 };
@@ -111,13 +1351,44 @@ static void print_usage(const RK_CHAR *name) {
 	printf("\t-w | --width: input image with, Default 720\n");
 	printf("\t-h | --height: input image height, Default 480\n");
 	printf("\t-t | --detectrate:  Default 10\n");
-	printf("\t-p | --path: input image path, Default NULL\n");
+	printf("\t-p | --path: input image path (.yuv or .yuvseq container), Default NULL\n");
 	printf("\t-l | --model_path: model path, Default /tmp/\n");
 	printf("\t-n | --model_name: model name, Default iva_object_detection_v3_pfp_nn_640x384.data\n");
 	printf("\t-d | --directory: input images directory, Default NULL\n");
 	printf("\t-r | --framerate: iva detect framerate, Default 10\n");
 	// 添加结果输出选项说明
 	printf("\t-o | --result_output: output result file path, Default NULL\n");
+	printf("\t--pipeline_depth: DMA buffer ring depth for read/inference overlap, Default 4\n");
+	printf("\t--mmap: read input YUV files via mmap instead of read(), Default off\n");
+	printf("\t--instances: parallel IVA engine instances, file list is sharded across them, Default 1\n");
+	printf("\t--result_format: result file format txt or bin, Default txt\n");
+	printf("\t--benchmark: disable framerate pacing, report fps and p50/p95/p99 latency\n");
+	printf("\t--preload: load whole directory into DMA-backed cache at startup\n");
+	printf("\t--preload_mem: preload cache cap in MB, Default 256\n");
+	printf("\t--batch: frames pushed back-to-back before pacing, Default 1\n");
+	printf("\t--video: compressed input stream (.h264/.h265/.mjpeg), hardware decoded, loops until SIGINT\n");
+	printf("\t--analyze: online score/type analysis in the result callback, summary and per-range file lists at exit\n");
+	printf("\t--readahead: files advised ahead of the reader in directory mode, 0 disables, Default 2\n");
+	printf("\t--audit: report per-frame syscall counts and steady-state heap growth at exit\n");
+	printf("\t--resume: continue an interrupted run from the <result file>.ckpt sidecar\n");
+	printf("\t--roi: detect sub-window x,y,w,h in pixels, Default full frame\n");
+	printf("\t--roi_file: per-file ROI manifest (lines of \"name x y w h\"), filters results in directory mode\n");
+	printf("\t--jobs: job manifest (lines of \"dir width height rate output\"), run sequentially in one process\n");
+	printf("\t--model_cache: keep the model pinned in /dev/shm across restarts for warm startup\n");
+	printf("\t--realtime: drop frames to stay on the detect rate timeline when the NPU falls behind\n");
+	printf("\t--shm_publish: publish results to the %s shared-memory ring for local consumers\n", SHM_RESULT_NAME);
+	printf("\t--affinity: comma-separated core list, pipeline threads are pinned per instance\n");
+	printf("\t--sched_fifo: run pipeline threads with SCHED_FIFO at the given priority (1-99)\n");
+	printf("\t--input_size: source frame WxH, frames are preprocessed to the model size on the fly\n");
+	printf("\t--preprocess: scale (nearest, NEON fast path) or crop (center), Default scale\n");
+	printf("\t--stdin: read fixed-size NV12 frames from stdin (pipe ffmpeg rawvideo output in)\n");
+	printf("\t--socket: accept NV12 frames on a UNIX socket path, or a TCP port if numeric\n");
+	printf("\t--bench_suite: run a jobs-format manifest as a benchmark, results in bin format plus .perf baselines\n");
+	printf("\t--golden: directory with a previous --bench_suite run, diff detections and performance against it\n");
+	printf("\t--filter_types: comma-separated class names (e.g. PERSON,VEHICLE), other objects are dropped before writing\n");
+	printf("\t--min_score: drop objects below this score before writing, Default 0\n");
+	printf("\t--coordinator: serve file-index batches on this TCP port and merge worker results into -o\n");
+	printf("\t--worker: pull batches from a coordinator at host:port, stream bin results back\n");
 }
 
 // 添加函数：检查文件扩展名是否为YUV
@@ -127,138 +1398,697 @@ static int is_yuv_file(const char *filename) {
     return (strcmp(dot, ".yuv") == 0 || strcmp(dot, ".YUV") == 0);
 }
 
-// 扫描指定目录下的所有YUV文件
-static int scan_yuv_directory(const char *dir_path) {
-    DIR *dir;
-    struct dirent *entry;
-    struct stat statbuf;
-    char full_path[512];
-    
-    // 打开目录
-    dir = opendir(dir_path);
-    if (!dir) {
-        RK_LOGE("Cannot open directory: %s", dir_path);
-        return -1;
+// 添加函数：检查文件扩展名是否为yuvseq容器
+static int is_yuvseq_file(const char *filename) {
+    const char *dot = strrchr(filename, '.');
+    if (!dot || dot == filename) return 0;
+    return (strcmp(dot, ".yuvseq") == 0 || strcmp(dot, ".YUVSEQ") == 0);
+}
+
+// 打开并校验yuvseq容器，成功后g_yuvseq_fd保持打开供pread使用
+static RK_S32 yuvseq_open(const char *file_path, RK_U32 width, RK_U32 height) {
+    YUVSEQ_HEADER_S header;
+
+    g_yuvseq_fd = open(file_path, O_RDONLY);
+    if (g_yuvseq_fd < 0) {
+        RK_LOGE("open yuvseq %s failed because %s", file_path, strerror(errno));
+        return RK_FAILURE;
     }
-    
-    // 先计算YUV文件数量
-    int count = 0;
-    while ((entry = readdir(dir)) != NULL) {
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
-        if (stat(full_path, &statbuf) == 0 && S_ISREG(statbuf.st_mode)) {
-            if (is_yuv_file(entry->d_name)) {
-                count++;
-            }
-        }
+
+    if (read(g_yuvseq_fd, &header, sizeof(header)) != sizeof(header) ||
+        header.magic != YUVSEQ_MAGIC) {
+        RK_LOGE("%s is not a valid yuvseq container", file_path);
+        close(g_yuvseq_fd);
+        g_yuvseq_fd = -1;
+        return RK_FAILURE;
     }
-    
-    closedir(dir);
-    
-    if (count == 0) {
-        RK_LOGE("No YUV files found in directory: %s", dir_path);
-        return -1;
+
+    // 容器中的分辨率必须与命令行指定的一致，否则帧偏移计算会错位
+    if (header.width != width || header.height != height) {
+        RK_LOGE("yuvseq resolution %ux%u mismatch with -w/-h %ux%u",
+                header.width, header.height, width, height);
+        close(g_yuvseq_fd);
+        g_yuvseq_fd = -1;
+        return RK_FAILURE;
     }
-    
-    // 分配内存存储文件路径
-    yuv_files = (char **)malloc(count * sizeof(char *));
-    if (!yuv_files) {
-        RK_LOGE("Failed to allocate memory for file list");
-        return -1;
+
+    g_yuvseq_frames = header.frame_count;
+
+    // 预格式化全部帧名；失败不致命，读线程退回每帧snprintf
+    if (g_yuvseq_frames > 0) {
+        size_t name_len = strlen(file_path) + 16;
+        g_yuvseq_name_arena = (char *)malloc((size_t)g_yuvseq_frames * name_len);
+        g_yuvseq_names = (char **)malloc(g_yuvseq_frames * sizeof(char *));
+        if (g_yuvseq_name_arena && g_yuvseq_names) {
+            for (RK_U32 n = 0; n < g_yuvseq_frames; n++) {
+                g_yuvseq_names[n] = g_yuvseq_name_arena + (size_t)n * name_len;
+                snprintf(g_yuvseq_names[n], name_len, "%s#%06u", file_path, n);
+            }
+        } else {
+            free(g_yuvseq_name_arena);
+            g_yuvseq_name_arena = NULL;
+            free(g_yuvseq_names);
+            g_yuvseq_names = NULL;
+        }
     }
-    
-    // 重新扫描并存储文件路径
+
+    RK_LOGI("yuvseq %s opened: %ux%u, %u frames", file_path,
+            header.width, header.height, g_yuvseq_frames);
+    return RK_SUCCESS;
+}
+
+// 自然序比较：文件名中的数字段按数值大小比较，
+// 使frame_2排在frame_10之前，保证视频抽帧的时序不被字典序打乱
+static int natural_compare(const void *a, const void *b) {
+    const char *sa = *(const char *const *)a;
+    const char *sb = *(const char *const *)b;
+
+    while (*sa && *sb) {
+        if (isdigit((unsigned char)*sa) && isdigit((unsigned char)*sb)) {
+            char *end_a, *end_b;
+            unsigned long long na = strtoull(sa, &end_a, 10);
+            unsigned long long nb = strtoull(sb, &end_b, 10);
+            if (na != nb)
+                return (na > nb) ? 1 : -1;
+            sa = end_a;
+            sb = end_b;
+        } else {
+            if (*sa != *sb)
+                return (unsigned char)*sa - (unsigned char)*sb;
+            sa++;
+            sb++;
+        }
+    }
+    return (unsigned char)*sa - (unsigned char)*sb;
+}
+
+// 扫描指定目录下的所有YUV文件
+// 单次遍历写入连续arena，结束后按自然序排序指针表，查找为O(1)下标访问
+static int scan_yuv_directory(const char *dir_path) {
+    DIR *dir;
+    struct dirent *entry;
+    char full_path[512];
+    char *arena = NULL;
+    size_t arena_used = 0;
+    size_t arena_cap = 0;
+    size_t *offsets = NULL;
+    int count = 0;
+    int offsets_cap = 0;
+
+    // 打开目录
     dir = opendir(dir_path);
     if (!dir) {
-        free(yuv_files);
-        yuv_files = NULL;
+        RK_LOGE("Cannot open directory: %s", dir_path);
         return -1;
     }
-    
-
-    int index = 0;
-    while ((entry = readdir(dir)) != NULL && index < count) {
-        snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
-        if (stat(full_path, &statbuf) == 0 && S_ISREG(statbuf.st_mode)) {
-            if (is_yuv_file(entry->d_name)) {
-                yuv_files[index] = strdup(full_path);
-                if (!yuv_files[index]) {
-                    // 清理已分配的内存
-                    for (int i = 0; i < index; i++) {
-                        free(yuv_files[i]);
-                    }
-                    free(yuv_files);
-                    yuv_files = NULL;
-                    closedir(dir);
-                    return -1;
-                }
-                index++;
-            }
+
+    // 单次扫描：路径字节追加进arena，记录每个条目的偏移
+    while ((entry = readdir(dir)) != NULL) {
+        if (!is_yuv_file(entry->d_name))
+            continue;
+        // d_type已知时直接过滤非普通文件，省掉一次stat；符号链接
+        // 和未知类型走下面的stat确认（stat跟随链接，链接到普通
+        // 文件的条目照常收录，数据集常用软链拼接）
+        if (entry->d_type != DT_REG && entry->d_type != DT_LNK &&
+            entry->d_type != DT_UNKNOWN)
+            continue;
+
+        int len = snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, entry->d_name);
+        if (len <= 0 || len >= (int)sizeof(full_path))
+            continue;
+
+        if (entry->d_type != DT_REG) {
+            // 文件系统不提供d_type或是符号链接时回退stat确认
+            struct stat statbuf;
+            if (stat(full_path, &statbuf) != 0 || !S_ISREG(statbuf.st_mode))
+                continue;
+        }
+
+        // arena和偏移表按倍增扩容
+        if (arena_used + len + 1 > arena_cap) {
+            size_t new_cap = arena_cap ? arena_cap * 2 : 64 * 1024;
+            while (new_cap < arena_used + len + 1)
+                new_cap *= 2;
+            char *new_arena = (char *)realloc(arena, new_cap);
+            if (!new_arena)
+                goto scan_fail;
+            arena = new_arena;
+            arena_cap = new_cap;
+        }
+        if (count >= offsets_cap) {
+            int new_cap = offsets_cap ? offsets_cap * 2 : 1024;
+            size_t *new_offsets = (size_t *)realloc(offsets, new_cap * sizeof(size_t));
+            if (!new_offsets)
+                goto scan_fail;
+            offsets = new_offsets;
+            offsets_cap = new_cap;
         }
+
+        memcpy(arena + arena_used, full_path, len + 1);
+        offsets[count++] = arena_used;
+        arena_used += len + 1;
     }
-    
     closedir(dir);
+    dir = NULL;
+
+    if (count == 0) {
+        RK_LOGE("No YUV files found in directory: %s", dir_path);
+        free(arena);
+        free(offsets);
+        return -1;
+    }
+
+    // 构建指针表并按自然序排序
+    yuv_files = (char **)malloc(count * sizeof(char *));
+    if (!yuv_files)
+        goto scan_fail;
+    for (int i = 0; i < count; i++)
+        yuv_files[i] = arena + offsets[i];
+    free(offsets);
+    qsort(yuv_files, count, sizeof(char *), natural_compare);
+
+    g_yuv_path_arena = arena;
     yuv_file_count = count;
-    RK_LOGI("Found %d YUV files in directory %s", yuv_file_count, dir_path);
+    RK_LOGI("Found %d YUV files in directory %s (%zu bytes of paths)",
+            yuv_file_count, dir_path, arena_used);
     return 0;
+
+scan_fail:
+    RK_LOGE("Failed to allocate memory for file list");
+    if (dir)
+        closedir(dir);
+    free(arena);
+    free(offsets);
+    return -1;
 }
 
 // 添加函数：释放文件列表内存
 static void free_yuv_files() {
     if (yuv_files) {
-        for (int i = 0; i < yuv_file_count; i++) {
-            if (yuv_files[i]) {
-                free(yuv_files[i]);
-            }
-        }
         free(yuv_files);
         yuv_files = NULL;
+        free(g_yuv_path_arena);
+        g_yuv_path_arena = NULL;
         yuv_file_count = 0;
     }
 }
 
+// 根据视频文件扩展名选择解码器类型
+static RK_CODEC_ID_E vdec_codec_from_path(const char *file_path) {
+	const char *dot = strrchr(file_path, '.');
+	if (dot && (strcmp(dot, ".h265") == 0 || strcmp(dot, ".hevc") == 0 ||
+	            strcmp(dot, ".265") == 0))
+		return RK_VIDEO_ID_HEVC;
+	if (dot && (strcmp(dot, ".jpg") == 0 || strcmp(dot, ".jpeg") == 0 ||
+	            strcmp(dot, ".mjpeg") == 0))
+		return RK_VIDEO_ID_MJPEG;
+	return RK_VIDEO_ID_AVC;
+}
+
+// 创建VDEC通道并打开码流文件，必须在RK_MPI_SYS_Init之后调用
+static RK_S32 vdec_input_init(RK_U32 width, RK_U32 height) {
+	VDEC_CHN_ATTR_S attr;
+	RK_S32 s32Ret;
+
+	g_video_file = fopen(g_video_path, "rb");
+	if (!g_video_file) {
+		RK_LOGE("open video %s failed because %s", g_video_path, strerror(errno));
+		return RK_FAILURE;
+	}
+
+	memset(&attr, 0, sizeof(attr));
+	attr.enType = vdec_codec_from_path(g_video_path);
+	attr.enMode = VIDEO_MODE_STREAM;
+	attr.u32PicWidth = width;
+	attr.u32PicHeight = height;
+	// 解码缓冲数跟随流水线深度，保证解码先行于推理
+	attr.u32FrameBufCnt = g_pipeline_depth + 2;
+	attr.u32StreamBufCnt = g_pipeline_depth + 2;
+	s32Ret = RK_MPI_VDEC_CreateChn(g_vdec_chn, &attr);
+	if (s32Ret != RK_SUCCESS) {
+		RK_LOGE("RK_MPI_VDEC_CreateChn failed %#X", s32Ret);
+		fclose(g_video_file);
+		g_video_file = NULL;
+		return RK_FAILURE;
+	}
+	RK_MPI_VDEC_StartRecvStream(g_vdec_chn);
+	g_vdec_inited = 1;
+	RK_LOGI("vdec input %s opened (codec %d)", g_video_path, attr.enType);
+	return RK_SUCCESS;
+}
+
+// 销毁VDEC通道并关闭码流文件
+static void vdec_input_deinit(void) {
+	if (g_vdec_inited) {
+		RK_MPI_VDEC_StopRecvStream(g_vdec_chn);
+		RK_MPI_VDEC_DestroyChn(g_vdec_chn);
+		g_vdec_inited = 0;
+	}
+	if (g_video_file) {
+		fclose(g_video_file);
+		g_video_file = NULL;
+	}
+}
+
+// 取一帧解码结果到槽位DMA缓冲；解码器空转时继续喂码流，
+// 文件读完则回绕到开头循环播放
+static RK_S32 vdec_read_frame(FRAME_SLOT_S *slot, RK_U32 width, RK_U32 height) {
+	VIDEO_FRAME_INFO_S frame;
+	VDEC_STREAM_S stream;
+	RK_U8 chunk[VDEC_CHUNK_SIZE];
+	RK_S32 s32Ret;
+
+	while (!quit) {
+		s32Ret = RK_MPI_VDEC_GetFrame(g_vdec_chn, &frame, 30);
+		if (s32Ret == RK_SUCCESS) {
+			// 按解码器的行对齐逐行拷贝Y和UV平面
+			RK_U8 *src = (RK_U8 *)RK_MPI_MB_Handle2VirAddr(frame.stVFrame.pMbBlk);
+			RK_U8 *dst = (RK_U8 *)slot->vaddr;
+			RK_U32 stride = frame.stVFrame.u32VirWidth;
+			if (stride == width) {
+				memcpy(dst, src, width * height * 3 / 2);
+			} else {
+				for (RK_U32 row = 0; row < height; row++)
+					memcpy(dst + row * width, src + row * stride, width);
+				RK_U8 *src_uv = src + stride * frame.stVFrame.u32VirHeight;
+				RK_U8 *dst_uv = dst + width * height;
+				for (RK_U32 row = 0; row < height / 2; row++)
+					memcpy(dst_uv + row * width, src_uv + row * stride, width);
+			}
+			RK_MPI_SYS_MmzFlushCache(slot->blk, RK_FALSE);
+			RK_MPI_VDEC_ReleaseFrame(g_vdec_chn, &frame);
+			return RK_SUCCESS;
+		}
+
+		// 没有可取的解码帧：继续喂一段码流（流模式下由解码器自行分帧）
+		size_t n = fread(chunk, 1, VDEC_CHUNK_SIZE, g_video_file);
+		if (n == 0) {
+			// 码流读完，回绕循环播放
+			rewind(g_video_file);
+			continue;
+		}
+
+		MB_BLK stream_blk = RK_NULL;
+		s32Ret = RK_MPI_SYS_MmzAlloc(&stream_blk, RK_NULL, RK_NULL, n);
+		if (s32Ret != RK_SUCCESS) {
+			RK_LOGE("alloc vdec stream buffer failed %#X", s32Ret);
+			return RK_FAILURE;
+		}
+		memcpy(RK_MPI_MB_Handle2VirAddr(stream_blk), chunk, n);
+		memset(&stream, 0, sizeof(stream));
+		stream.pMbBlk = stream_blk;
+		stream.u32Len = n;
+		stream.u64PTS = 0;
+		stream.bEndOfFrame = RK_FALSE;
+		stream.bEndOfStream = RK_FALSE;
+		RK_MPI_VDEC_SendStream(g_vdec_chn, &stream, -1);
+		RK_MPI_MB_ReleaseMB(stream_blk);
+	}
+	return RK_FAILURE;
+}
+
+// 流式输入（--stdin / --socket）：定长NV12帧从管道或套接字直接读进
+// DMA槽位，零中间存储。实况回放从此不用先把帧铺到磁盘再读回来：
+//   ffmpeg -i cam.mp4 -f rawvideo -pix_fmt nv12 pipe:1 | 本程序 --stdin
+// 背压走缓冲环：没有空闲槽位时读线程不从fd取数据，内核管道/套接字
+// 缓冲随之填满，上游发送端自然被顶住。--socket为UNIX套接字路径，
+// 纯数字则按TCP端口监听；单一字节流无法分片，只支持单实例
+static RK_S32 g_stdin_input = 0;
+static char *g_socket_spec = NULL;
+static RK_S32 g_stream_fd = -1;
+static char g_stream_unix_path[256] = {0};
+
+// 整帧读取：处理短读与EINTR，EOF或出错返回失败。
+// 先poll（最多100ms）再read：别的线程出错置位quit时不会有信号来
+// 打断read，靠poll超时醒来检查，阻塞读不再卡住整个退出流程
+static RK_S32 stream_read_full(RK_S32 fd, void *buf, RK_U32 size) {
+	RK_U8 *p = (RK_U8 *)buf;
+	RK_U32 got = 0;
+	struct pollfd pfd;
+	while (got < size && !quit) {
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		RK_S32 pr = poll(&pfd, 1, 100);
+		if (pr < 0 && errno != EINTR)
+			return RK_FAILURE;
+		if (pr <= 0)
+			continue;
+		ssize_t n = read(fd, p + got, size - got);
+		if (n > 0) {
+			got += (RK_U32)n;
+		} else if (n < 0 && errno == EINTR) {
+			continue;
+		} else {
+			return RK_FAILURE;
+		}
+	}
+	return got == size ? RK_SUCCESS : RK_FAILURE;
+}
+
+// 打开流式输入：标准输入直接用fd 0；套接字监听并等待一个连接
+static RK_S32 stream_input_open(void) {
+	if (g_stdin_input) {
+		g_stream_fd = STDIN_FILENO;
+		RK_LOGI("stream input from stdin");
+		return RK_SUCCESS;
+	}
+
+	RK_S32 listen_fd;
+	RK_S32 is_tcp = 1;
+	for (const char *c = g_socket_spec; *c; c++)
+		if (!isdigit((unsigned char)*c))
+			is_tcp = 0;
+
+	if (is_tcp) {
+		struct sockaddr_in addr;
+		listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (listen_fd < 0) {
+			RK_LOGE("socket failed because %s", strerror(errno));
+			return RK_FAILURE;
+		}
+		int one = 1;
+		setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_addr.s_addr = INADDR_ANY;
+		addr.sin_port = htons((unsigned short)atoi(g_socket_spec));
+		if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+			RK_LOGE("bind port %s failed because %s", g_socket_spec, strerror(errno));
+			close(listen_fd);
+			return RK_FAILURE;
+		}
+	} else {
+		struct sockaddr_un addr;
+		listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (listen_fd < 0) {
+			RK_LOGE("socket failed because %s", strerror(errno));
+			return RK_FAILURE;
+		}
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, g_socket_spec, sizeof(addr.sun_path) - 1);
+		unlink(g_socket_spec);
+		if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+			RK_LOGE("bind %s failed because %s", g_socket_spec, strerror(errno));
+			close(listen_fd);
+			return RK_FAILURE;
+		}
+		strncpy(g_stream_unix_path, g_socket_spec, sizeof(g_stream_unix_path) - 1);
+	}
+
+	if (listen(listen_fd, 1) < 0) {
+		RK_LOGE("listen failed because %s", strerror(errno));
+		close(listen_fd);
+		return RK_FAILURE;
+	}
+	RK_LOGI("stream input listening on %s, waiting for sender", g_socket_spec);
+	// 不能裸accept：glibc的signal()带SA_RESTART，Ctrl-C只会让accept
+	// 原地重来，进程杀不掉。带超时poll，轮询间隙看quit
+	g_stream_fd = -1;
+	while (!quit) {
+		struct pollfd pfd;
+		pfd.fd = listen_fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 500) > 0) {
+			g_stream_fd = accept(listen_fd, NULL, NULL);
+			break;
+		}
+	}
+	close(listen_fd);
+	if (g_stream_fd < 0) {
+		if (quit)
+			RK_LOGI("quit while waiting for stream sender");
+		else
+			RK_LOGE("accept failed because %s", strerror(errno));
+		return RK_FAILURE;
+	}
+	RK_LOGI("stream sender connected");
+	return RK_SUCCESS;
+}
+
+// 关闭流式输入并清掉UNIX套接字残留的路径节点
+static void stream_input_close(void) {
+	if (g_stream_fd >= 0 && g_stream_fd != STDIN_FILENO)
+		close(g_stream_fd);
+	g_stream_fd = -1;
+	if (g_stream_unix_path[0]) {
+		unlink(g_stream_unix_path);
+		g_stream_unix_path[0] = '\0';
+	}
+}
+
+// 预载目录中的YUV文件到DMA缓存块，受g_preload_mem_cap限制
+// 必须在RK_MPI_SYS_Init之后调用；放不下的文件保持磁盘读取路径
+static RK_S32 preload_init(RK_U32 frame_size) {
+	MB_POOL_CONFIG_S pool_cfg;
+	RK_S32 target = yuv_file_count;
+	RK_S32 max_by_mem = (RK_S32)(g_preload_mem_cap / frame_size);
+
+	if (!yuv_files || yuv_file_count <= 0) {
+		RK_LOGE("preload requires directory mode, ignored");
+		return RK_SUCCESS;
+	}
+	if (target > max_by_mem) {
+		RK_LOGE("preload cap %lld bytes fits %d of %d files, rest read from disk",
+		        g_preload_mem_cap, max_by_mem, target);
+		target = max_by_mem;
+	}
+	if (target <= 0)
+		return RK_SUCCESS;
+
+	memset(&pool_cfg, 0, sizeof(MB_POOL_CONFIG_S));
+	pool_cfg.u64MBSize = frame_size;
+	pool_cfg.u32MBCnt = target;
+	pool_cfg.enAllocType = MB_ALLOC_TYPE_DMA;
+	pool_cfg.bPreAlloc = RK_FALSE;
+	g_preload_pool_id = RK_MPI_MB_CreatePool(&pool_cfg);
+	if (g_preload_pool_id == MB_INVALID_POOLID) {
+		RK_LOGE("create preload pool failed, fallback to disk reads");
+		return RK_SUCCESS;
+	}
+
+	g_preload_entries = (PRELOAD_ENTRY_S *)calloc(target, sizeof(PRELOAD_ENTRY_S));
+	if (!g_preload_entries) {
+		RK_MPI_MB_DestroyPool(g_preload_pool_id);
+		return RK_FAILURE;
+	}
+
+	for (RK_S32 i = 0; i < target; i++) {
+		PRELOAD_ENTRY_S *entry = &g_preload_entries[i];
+		entry->blk = RK_MPI_MB_GetMB(g_preload_pool_id, frame_size, RK_TRUE);
+		if (entry->blk == MB_INVALID_HANDLE) {
+			// CMA耗尽：已装载的部分照常使用，其余走磁盘
+			RK_LOGE("preload stops at %d of %d files (CMA exhausted)", i, target);
+			break;
+		}
+		entry->vaddr = RK_MPI_MB_Handle2VirAddr(entry->blk);
+		entry->fd = RK_MPI_MB_Handle2Fd(entry->blk);
+
+		RK_S32 file_fd = open(yuv_files[i], O_RDONLY);
+		if (file_fd < 0) {
+			RK_LOGE("preload open %s failed because %s", yuv_files[i], strerror(errno));
+			memset(entry->vaddr, 0, frame_size);
+		} else {
+			if (read(file_fd, entry->vaddr, frame_size) != (RK_S32)frame_size)
+				RK_LOGE("preload short read on %s", yuv_files[i]);
+			close(file_fd);
+		}
+		RK_MPI_SYS_MmzFlushCache(entry->blk, RK_FALSE);
+		g_preload_count = i + 1;
+	}
+
+	g_mem_preload_bytes = (long long)g_preload_count * frame_size;
+	RK_LOGI("preloaded %d of %d files (%lld bytes)", g_preload_count,
+	        yuv_file_count, g_mem_preload_bytes);
+	return RK_SUCCESS;
+}
+
+// 释放预载缓存
+static void preload_deinit(void) {
+	if (g_preload_entries) {
+		for (RK_S32 i = 0; i < g_preload_count; i++) {
+			if (g_preload_entries[i].blk != MB_INVALID_HANDLE)
+				RK_MPI_MB_ReleaseMB(g_preload_entries[i].blk);
+		}
+		free(g_preload_entries);
+		g_preload_entries = NULL;
+		RK_MPI_MB_DestroyPool(g_preload_pool_id);
+		g_preload_count = 0;
+		g_mem_preload_bytes = 0;
+	}
+}
+
+// 启动预检：按CmaFree余量裁剪流水线深度，不让池子建到一半才发现
+// CMA不够。预算取余量的3/4（剩下留给VDEC和其他内核CMA用户），
+// 启用预载时先扣掉预载上限。读不到CmaFree（内核未开CMA统计）则跳过
+static void mem_preflight(RK_U32 frame_size) {
+	g_mem_cma_free_kb = mem_read_cma_free_kb();
+	if (g_mem_cma_free_kb < 0) {
+		RK_LOGI("mem preflight: CmaFree not available, skip ring sizing");
+		return;
+	}
+	long long budget = g_mem_cma_free_kb * 1024 * 3 / 4;
+	if (g_preload_enable)
+		budget -= g_preload_mem_cap;
+	long long per_depth = (long long)frame_size * g_instance_count;
+	RK_S32 max_depth = (budget > 0) ? (RK_S32)(budget / per_depth) : 0;
+	// 低于2帧流水线就退化成同步提交了，宁可贴着水位跑
+	if (max_depth < 2)
+		max_depth = 2;
+	if (g_pipeline_depth > max_depth) {
+		RK_LOGE("mem preflight: CmaFree %lld kB fits %d buffers of %u bytes "
+		        "x %d inst, clamp pipeline depth %d -> %d",
+		        g_mem_cma_free_kb, max_depth, frame_size, g_instance_count,
+		        g_pipeline_depth, max_depth);
+		g_pipeline_depth = max_depth;
+	} else {
+		RK_LOGI("mem preflight: CmaFree %lld kB, depth %d x %d inst x %u bytes fits",
+		        g_mem_cma_free_kb, g_pipeline_depth, g_instance_count, frame_size);
+	}
+}
+
 // IVA检测结果回调函数，当IVA完成一帧图像处理后调用此函数
+// 类型字符串映射表：static const放在文件作用域，
+// 不在每次回调的栈上重新初始化一遍
+static const char *const g_type_str[] = {
+	"NONE",     // ROCKIVA_OBJECT_TYPE_NONE = 0
+	"PERSON",   // ROCKIVA_OBJECT_TYPE_PERSON = 1
+	"VEHICLE",  // ROCKIVA_OBJECT_TYPE_VEHICLE = 2
+	"NON_VEHICLE", // ROCKIVA_OBJECT_TYPE_NON_VEHICLE = 3
+	"FACE",     // ROCKIVA_OBJECT_TYPE_FACE = 4
+	"HEAD",     // ROCKIVA_OBJECT_TYPE_HEAD = 5
+	"PET",      // ROCKIVA_OBJECT_TYPE_PET = 6
+	"MOTORCYCLE", // ROCKIVA_OBJECT_TYPE_MOTORCYCLE = 7
+	"BICYCLE",  // ROCKIVA_OBJECT_TYPE_BICYCLE = 8
+	"PLATE",    // ROCKIVA_OBJECT_TYPE_PLATE = 9
+	"BABY",     // ROCKIVA_OBJECT_TYPE_BABY = 10
+	"PACKAGE"   // ROCKIVA_OBJECT_TYPE_PACKAGE = 11
+};
+
 static void rkIvaEvent_callback(const RockIvaDetectResult *result,
                                 const RockIvaExecuteStatus status, void *userData) {
 
 	RK_LOGI("objnum %d, status %d", result->objNum, status);
 
+	IVA_INSTANCE_S *inst = instance_from_userdata(userData);
+	long long now_us = get_time_us();
+	char *current_file = NULL;
+
+	// 回调线程由IVA库创建，无法在创建时设属性，首次回调就地绑核/提权
+	if ((g_affinity_core_count > 0 || g_sched_fifo_prio > 0) && !inst->cb_tuned) {
+		inst->cb_tuned = 1;
+		pipeline_thread_tune(inst->inst_id);
+	}
+
+	// results_received在记录真正进入输出缓冲时才加（持结果锁），
+	// 断点sidecar的done数才不会超前于已落盘的记录
+	inst->last_result_ms = now_us / 1000;
+	inst->last_result_us = now_us;
+
+	// 按提交顺序消费在途FIFO：取本帧来源文件、帧号并采样单帧延迟
+	RK_U32 current_frame_id = 0;
+	if (inst->inflight_paths && inst->inflight_rd < inst->inflight_wr) {
+		RK_U32 fifo_slot = inst->inflight_rd % inst->inflight_cap;
+		current_file = inst->inflight_paths[fifo_slot];
+		current_frame_id = inst->inflight_frame_ids[fifo_slot];
+		stage_record(STAGE_RESULT, now_us - inst->inflight_push_us[fifo_slot]);
+		if (g_benchmark_mode && inst->lat_samples && inst->lat_count < inst->lat_cap)
+			inst->lat_samples[inst->lat_count++] =
+			    (long)((now_us - inst->inflight_push_us[fifo_slot]) / 1000);
+		inst->inflight_rd++;
+	} else if (path) {
+		// 单文件模式
+		current_file = path;
+	}
+
+	// 在线分析：结果一到就更新统计，不用等跑完再扫结果文件
+	if (g_analyze_enable)
+		analyze_record(current_file, result);
+
+	// 结果总线：先发布原始结果，本机消费者不等文件落盘
+	if (g_shm_publish_enable && g_shm_ring)
+		shm_publish_record(current_file, result);
+
+	// 逐文件ROI与类别/得分早筛：被筛掉的目标在任何格式化写入前丢弃。
+	// 通过位图只对每个对象判一次，写入循环直接查位
+	const ROI_ENTRY_S *roi = roi_lookup(current_file);
+	RK_U64 pass_mask[PASS_MASK_WORDS];
+	RK_S32 pass_num = result->objNum;
+	if (pass_num > RESULT_MAX_OBJS)
+		pass_num = RESULT_MAX_OBJS;
+	if (roi || g_filter_type_mask || g_min_score > 0) {
+		memset(pass_mask, 0, sizeof(pass_mask));
+		pass_num = 0;
+		for (int i = 0; i < result->objNum && i < RESULT_MAX_OBJS; i++) {
+			if (result_obj_pass(roi, &result->objInfo[i])) {
+				pass_mask[i >> 6] |= 1ULL << (i & 63);
+				pass_num++;
+			}
+		}
+	} else {
+		memset(pass_mask, 0xFF, sizeof(pass_mask));
+	}
+
+	// 二进制结果模式：拼装定长记录进聚合缓冲，满了或到时间才落盘
+	// （工作端模式没有本地结果文件，缓冲满了发回协调端）
+	if (g_result_format_bin && (result_output_file || g_worker_fd >= 0)) {
+		RESULT_BIN_FRAME_S frame_rec;
+		RESULT_BIN_OBJ_S obj_rec;
+		RK_U32 need = sizeof(frame_rec) + pass_num * sizeof(obj_rec);
+
+		pthread_mutex_lock(&g_result_file_mutex);
+		if (g_result_bin_used + need > RESULT_BIN_BUF_SIZE)
+			result_bin_flush();
+
+		// 帧号来自提交时登记的在途FIFO：无检出帧objInfo为空，
+		// 以前统统写成第0帧
+		frame_rec.frame_id = current_frame_id;
+		frame_rec.inst_id = inst->inst_id;
+		frame_rec.obj_num = pass_num;
+		memcpy(g_result_bin_buf + g_result_bin_used, &frame_rec, sizeof(frame_rec));
+		g_result_bin_used += sizeof(frame_rec);
+
+		for (int i = 0; i < result->objNum && i < RESULT_MAX_OBJS; i++) {
+			if (!(pass_mask[i >> 6] & (1ULL << (i & 63))))
+				continue;
+			obj_rec.top_left_x = result->objInfo[i].rect.topLeft.x;
+			obj_rec.top_left_y = result->objInfo[i].rect.topLeft.y;
+			obj_rec.bottom_right_x = result->objInfo[i].rect.bottomRight.x;
+			obj_rec.bottom_right_y = result->objInfo[i].rect.bottomRight.y;
+			obj_rec.obj_id = result->objInfo[i].objId;
+			obj_rec.score = result->objInfo[i].score;
+			obj_rec.type = result->objInfo[i].type;
+			memcpy(g_result_bin_buf + g_result_bin_used, &obj_rec, sizeof(obj_rec));
+			g_result_bin_used += sizeof(obj_rec);
+		}
+		inst->results_received++;
+
+		// 定时落盘，避免异常退出时丢太多记录
+		if (get_time_ms() - g_result_bin_last_flush_ms > RESULT_BIN_FLUSH_INTERVAL_MS)
+			result_bin_flush();
+		pthread_mutex_unlock(&g_result_file_mutex);
+		return;
+	}
+
 	// 如果设置了结果输出文件，则将结果写入文件
 	if (result_output_file) {
-		char *current_file = NULL;
-		if (yuv_files && yuv_file_count > 0) {
-			// 目录模式
-			int prev_index = (current_file_index == 0) ? (yuv_file_count - 1) : (current_file_index - 1);
-			current_file = yuv_files[prev_index];
-		} else if (path) {
-			// 单文件模式
-			current_file = path;
-		}
-		
 		if (current_file) {
+			// 多实例共享同一结果文件，整块写入需要串行化
+			pthread_mutex_lock(&g_result_file_mutex);
 			fprintf(result_output_file, "File: %s\n", current_file);
-			if (result->objNum > 0) {
-				fprintf(result_output_file, "Object count: %d, detected\n", result->objNum);
+			// 多实例模式下标记结果来源实例
+			if (g_instance_count > 1)
+				fprintf(result_output_file, "Instance: %d\n", inst->inst_id);
+			if (pass_num > 0) {
+				fprintf(result_output_file, "Object count: %d, detected\n", pass_num);
 			} else {
-				fprintf(result_output_file, "Object count: %d  not detect\n", result->objNum);
-			}
-			for (int i = 0; i < result->objNum; i++) {
-				// 添加类型字符串映射
-				const char* type_str[] = {
-					"NONE",     // ROCKIVA_OBJECT_TYPE_NONE = 0
-					"PERSON",   // ROCKIVA_OBJECT_TYPE_PERSON = 1
-					"VEHICLE",  // ROCKIVA_OBJECT_TYPE_VEHICLE = 2
-					"NON_VEHICLE", // ROCKIVA_OBJECT_TYPE_NON_VEHICLE = 3
-					"FACE",     // ROCKIVA_OBJECT_TYPE_FACE = 4
-					"HEAD",     // ROCKIVA_OBJECT_TYPE_HEAD = 5
-					"PET",      // ROCKIVA_OBJECT_TYPE_PET = 6
-					"MOTORCYCLE", // ROCKIVA_OBJECT_TYPE_MOTORCYCLE = 7
-					"BICYCLE",  // ROCKIVA_OBJECT_TYPE_BICYCLE = 8
-					"PLATE",    // ROCKIVA_OBJECT_TYPE_PLATE = 9
-					"BABY",     // ROCKIVA_OBJECT_TYPE_BABY = 10
-					"PACKAGE"   // ROCKIVA_OBJECT_TYPE_PACKAGE = 11
-				};
-				const char* type_name = (result->objInfo[i].type < ROCKIVA_OBJECT_TYPE_MAX) ? 
-					type_str[result->objInfo[i].type] : "UNKNOWN";
+				fprintf(result_output_file, "Object count: %d  not detect\n", pass_num);
+			}
+			for (int i = 0; i < result->objNum && i < RESULT_MAX_OBJS; i++) {
+				if (!(pass_mask[i >> 6] & (1ULL << (i & 63))))
+					continue;
+				const char* type_name = (result->objInfo[i].type < ROCKIVA_OBJECT_TYPE_MAX) ?
+					g_type_str[result->objInfo[i].type] : "UNKNOWN";
 				RK_LOGI("Object %d: topLeft:[%d,%d], bottomRight:[%d,%d],"
 				        "objId: %d, frameId: %d, score: %d, type: %d(%s)\n",
 				        i,
@@ -279,148 +2109,1231 @@ static void rkIvaEvent_callback(const RockIvaDetectResult *result,
 			}
 			fprintf(result_output_file, "\n");
 			fflush(result_output_file);
+			inst->results_received++;
+			pthread_mutex_unlock(&g_result_file_mutex);
+			return;
 		}
 	}
+
+	// 没写任何结果记录的配置（无结果输出或文本模式缺来源文件）：
+	// 吞吐统计仍要计数，在这里补上
+	inst->results_received++;
 }
 
 // IVA帧释放回调函数，当IVA处理完一帧图像后调用此函数通知可以继续处理下一帧
 static void rkIvaFrame_releaseCallBack(const RockIvaReleaseFrames *releaseFrames,
                                        void *userdata) {
 	/* 当IVA处理完视频帧时，此函数会被调用 */
+	IVA_INSTANCE_S *inst = instance_from_userdata(userdata);
 	RK_LOGD("release iva frame success!");
-	sem_post(&g_iva_semaphore); // 发送信号量，通知可以继续处理下一帧
+	// 释放回调线程同样在首次进入时就地绑核/提权
+	if ((g_affinity_core_count > 0 || g_sched_fifo_prio > 0) &&
+	    !inst->release_cb_tuned) {
+		inst->release_cb_tuned = 1;
+		pipeline_thread_tune(inst->inst_id);
+	}
+	// 每释放一帧就把对应槽位压入回收环（帧按提交顺序释放，
+	// 槽位按序号取模映射），回调只写无锁环，不再和提交路径抢锁
+	long long now_us = get_time_us();
+	for (RK_S32 i = 0; i < releaseFrames->count; i++) {
+		inst->frames_released++;
+		stage_record(STAGE_RELEASE, now_us - inst->last_result_us);
+		spsc_push(&inst->recycle_ring, inst->release_seq++ % g_pipeline_depth);
+	}
+}
+
+// NV12前处理（--input_size WxH，--preprocess scale|crop）：语料分辨率
+// 与模型输入不一致时，过去要用video_to_images.py按新尺寸把整套数据
+// 重抽一遍，几小时纯IO。现在读线程把原始帧读进暂存缓冲，缩放或中心
+// 裁剪成模型尺寸后直接写进MB池的DMA缓冲，转换在读线程里与NPU推理
+// 重叠，不占帧时间关键路径。缩放为最近邻采样，恰好2:1整除时走NEON
+// 向量化快路径；RGA硬件通路需要链接librga，本工程未引入，留CPU通路
+static RK_U32 g_input_width = 0;
+static RK_U32 g_input_height = 0;
+static RK_S32 g_preprocess_crop = 0;  // 0缩放 1中心裁剪
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// 最近邻缩放NV12：src(sw x sh) -> dst(dw x dh)，Y面与UV面分别采样
+static void nv12_scale(const RK_U8 *src, RK_U32 sw, RK_U32 sh,
+                       RK_U8 *dst, RK_U32 dw, RK_U32 dh) {
+#if defined(__ARM_NEON)
+	// 2:1整除快路径：vld2一次载入32个源字节并丢弃交错的另一半
+	if (sw == dw * 2 && sh == dh * 2 && (dw % 16) == 0) {
+		for (RK_U32 y = 0; y < dh; y++) {
+			const RK_U8 *s = src + (size_t)(y * 2) * sw;
+			RK_U8 *d = dst + (size_t)y * dw;
+			for (RK_U32 x = 0; x < dw; x += 16) {
+				uint8x16x2_t v = vld2q_u8(s + x * 2);
+				vst1q_u8(d + x, v.val[0]);
+			}
+		}
+		const RK_U8 *suv = src + (size_t)sw * sh;
+		RK_U8 *duv = dst + (size_t)dw * dh;
+		for (RK_U32 y = 0; y < dh / 2; y++) {
+			const RK_U8 *s = suv + (size_t)(y * 2) * sw;
+			RK_U8 *d = duv + (size_t)y * dw;
+			// UV交错成对，按16位为单位采样保持U/V配对不拆散
+			for (RK_U32 x = 0; x < dw; x += 16) {
+				uint16x8x2_t v = vld2q_u16((const RK_U16 *)(s + x * 2));
+				vst1q_u16((RK_U16 *)(d + x), v.val[0]);
+			}
+		}
+		return;
+	}
+#endif
+	// 通用路径：任意比例最近邻采样
+	for (RK_U32 y = 0; y < dh; y++) {
+		const RK_U8 *s = src + (size_t)((RK_U64)y * sh / dh) * sw;
+		RK_U8 *d = dst + (size_t)y * dw;
+		for (RK_U32 x = 0; x < dw; x++)
+			d[x] = s[(RK_U64)x * sw / dw];
+	}
+	const RK_U8 *suv = src + (size_t)sw * sh;
+	RK_U8 *duv = dst + (size_t)dw * dh;
+	for (RK_U32 y = 0; y < dh / 2; y++) {
+		const RK_U8 *s = suv + (size_t)((RK_U64)y * (sh / 2) / (dh / 2)) * sw;
+		RK_U8 *d = duv + (size_t)y * dw;
+		for (RK_U32 x = 0; x < dw; x += 2) {
+			RK_U32 sx = (RK_U32)((RK_U64)(x / 2) * (sw / 2) / (dw / 2)) * 2;
+			d[x] = s[sx];
+			d[x + 1] = s[sx + 1];
+		}
+	}
+}
+
+// 中心裁剪NV12：从源帧中部取dw x dh窗口，起点对齐到偶数保持UV配对
+static void nv12_center_crop(const RK_U8 *src, RK_U32 sw, RK_U32 sh,
+                             RK_U8 *dst, RK_U32 dw, RK_U32 dh) {
+	RK_U32 x0 = ((sw - dw) / 2) & ~1u;
+	RK_U32 y0 = ((sh - dh) / 2) & ~1u;
+	for (RK_U32 y = 0; y < dh; y++)
+		memcpy(dst + (size_t)y * dw, src + (size_t)(y0 + y) * sw + x0, dw);
+	const RK_U8 *suv = src + (size_t)sw * sh;
+	RK_U8 *duv = dst + (size_t)dw * dh;
+	for (RK_U32 y = 0; y < dh / 2; y++)
+		memcpy(duv + (size_t)y * dw, suv + (size_t)(y0 / 2 + y) * sw + x0, dw);
+}
+
+// 前处理入口：暂存缓冲里的原始帧 -> 槽位DMA缓冲里的模型尺寸帧
+static void nv12_preprocess(const RK_U8 *src, RK_U8 *dst, RK_U32 dw, RK_U32 dh) {
+	if (g_preprocess_crop && g_input_width >= dw && g_input_height >= dh)
+		nv12_center_crop(src, g_input_width, g_input_height, dst, dw, dh);
+	else
+		nv12_scale(src, g_input_width, g_input_height, dst, dw, dh);
+}
+
+// 使用mmap方式把YUV文件装载到DMA缓冲：映射文件后做一次cache一致的拷贝
+// madvise提示内核顺序预读，省掉read()路径上每帧的系统调用和分块拷贝开销
+// 开了前处理时映射的是原始分辨率帧，缩放/裁剪直接以映射页为源
+static RK_S32 load_frame_mmap(FRAME_SLOT_S *slot, const char *file_path,
+                              RK_U32 size, RK_U32 dst_w, RK_U32 dst_h) {
+	struct stat st;
+	RK_S32 fd = open(file_path, O_RDONLY);
+	if (fd < 0) {
+		RK_LOGE("open %s failed because %s", file_path, strerror(errno));
+		return RK_FAILURE;
+	}
+
+	if (fstat(fd, &st) < 0 || (RK_U32)st.st_size < size) {
+		RK_LOGE("stat %s failed or file too small", file_path);
+		close(fd);
+		return RK_FAILURE;
+	}
+
+	void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		RK_LOGE("mmap %s failed because %s", file_path, strerror(errno));
+		close(fd);
+		return RK_FAILURE;
+	}
+	madvise(map, size, MADV_SEQUENTIAL);
+	madvise(map, size, MADV_WILLNEED);
+
+	// 单次拷贝（或前处理）进DMA缓冲并刷新cache，保证NPU读到一致的数据
+	if (g_input_width)
+		nv12_preprocess((const RK_U8 *)map, (RK_U8 *)slot->vaddr, dst_w, dst_h);
+	else
+		memcpy(slot->vaddr, map, size);
+	long long copy_done_us = get_time_us();
+	RK_MPI_SYS_MmzFlushCache(slot->blk, RK_FALSE);
+	stage_record(STAGE_FLUSH, get_time_us() - copy_done_us);
+
+	munmap(map, size);
+	close(fd);
+	return RK_SUCCESS;
+}
+
+// 目录模式预读线程：沿本实例分片在读文件线程前方g_readahead_depth个
+// 文件发posix_fadvise(POSIX_FADV_WILLNEED)，内核提前把冷文件拉进
+// page cache，读线程的阻塞read()总能命中热页。NFS测试集上一次冷读
+// 要20~40ms，相当于30fps下好几个检测周期
+static void *readahead_thread(void *pArgs) {
+	IVA_INSTANCE_S *inst = (IVA_INSTANCE_S *)pArgs;
+	prctl(PR_SET_NAME, "readahead_thread");
+	pipeline_thread_tune(inst->inst_id);
+	RK_U32 ra_count = 0;
+	RK_S32 shard_len = inst->file_end - inst->file_begin;
+
+	if (shard_len <= 0)
+		return RK_NULL;
+
+	while (!quit && !inst->readahead_stop) {
+		// 最多领先读线程g_readahead_depth个文件，追平了就歇一下
+		if (ra_count >= inst->files_read + (RK_U32)g_readahead_depth) {
+			usleep(1000);
+			continue;
+		}
+		RK_S32 list_index = inst->file_begin + (RK_S32)(ra_count % (RK_U32)shard_len);
+		RK_S32 fd = open(yuv_files[list_index], O_RDONLY);
+		if (fd >= 0) {
+			posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+			close(fd);
+		}
+		ra_count++;
+	}
+
+	RK_LOGI("readahead_thread (inst %d) exit !!!", inst->inst_id);
+	return RK_NULL;
+}
+
+// 读文件线程：在IVA推理的同时把后续帧预读进空闲的DMA槽位
+static void *read_frame_thread(void *pArgs) {
+	IVA_INSTANCE_S *inst = (IVA_INSTANCE_S *)pArgs;
+	prctl(PR_SET_NAME, "read_frame_thread");
+	pipeline_thread_tune(inst->inst_id);
+	RK_S32 s32Ret;
+	RK_U32 size = inst->iva_ctx.u32ImageWidth * inst->iva_ctx.u32ImageHeight * 3 / 2;
+	// 前处理模式下从磁盘读的是原始分辨率帧，再压成模型尺寸
+	RK_U32 read_size =
+	    g_input_width ? g_input_width * g_input_height * 3 / 2 : size;
+	RK_S32 i = 0;
+
+	while (!quit && (inst->loop_count < 0 || i < inst->loop_count)) {
+		// 实时档：消费提交线程的跳帧请求——游标前跳、循环额度照扣，
+		// 和真实相机丢帧一样，被跳过的帧不装载也不提交
+		if (g_realtime_mode && inst->skip_request > 0 &&
+		    inst->file_end > inst->file_begin) {
+			RK_S32 n_skip = inst->skip_request;
+			__sync_fetch_and_sub(&inst->skip_request, n_skip);
+			if (inst->loop_count >= 0 && i + n_skip > inst->loop_count)
+				n_skip = inst->loop_count - i;
+			for (RK_S32 s = 0; s < n_skip; s++) {
+				i++;
+				inst->file_cursor++;
+				if (inst->file_cursor >= inst->file_end)
+					inst->file_cursor = inst->file_begin;
+			}
+			if (n_skip > 0) {
+				inst->frames_skipped += (RK_U32)n_skip;
+				__sync_fetch_and_add(&g_frames_skipped_total, (RK_U64)n_skip);
+			}
+			continue;
+		}
+
+		// 等待一个空闲槽位（IVA释放帧后经回收环归还）
+		RK_U32 slot_idx;
+		if (spsc_pop_spin(&inst->recycle_ring, &slot_idx) != RK_SUCCESS)
+			break;
+
+		FRAME_SLOT_S *slot = &inst->slots[slot_idx];
+
+		// 流式输入模式：从管道/套接字整帧读进DMA槽位（或前处理暂存）
+		// 背压天然成立：槽位是在上面pop到之后才开始读fd的
+		if (g_stream_fd >= 0) {
+			long long read_start_us = get_time_us();
+			void *read_dst = g_input_width ? (void *)inst->pre_buf : slot->vaddr;
+			if (stream_read_full(g_stream_fd, read_dst, read_size) != RK_SUCCESS) {
+				RK_LOGI("stream input closed after %d frames", i);
+				// 槽位就地放弃，不回塞recycle_ring：该环的唯一生产者是
+				// 释放回调，这里再push就是双生产者，发送端靠reader_done退出
+				break;
+			}
+			if (g_input_width)
+				nv12_preprocess(inst->pre_buf, (RK_U8 *)slot->vaddr,
+				                inst->iva_ctx.u32ImageWidth,
+				                inst->iva_ctx.u32ImageHeight);
+			long long read_done_us = get_time_us();
+			stage_record(STAGE_READ, read_done_us - read_start_us);
+			RK_MPI_SYS_MmzFlushCache(slot->blk, RK_FALSE);
+			stage_record(STAGE_FLUSH, get_time_us() - read_done_us);
+			snprintf(slot->seq_name, sizeof(slot->seq_name), "stream#%06d", i);
+			slot->src_path = slot->seq_name;
+			slot->frame_id = ++i;
+			slot->push_fd = slot->fd;
+			spsc_push(&inst->filled_ring, slot_idx);
+			continue;
+		}
+
+		// 压缩视频模式：从VDEC取硬解码帧，解码与推理重叠
+		if (g_vdec_inited) {
+			long long read_start_us = get_time_us();
+			if (vdec_read_frame(slot, inst->iva_ctx.u32ImageWidth,
+			                    inst->iva_ctx.u32ImageHeight) != RK_SUCCESS)
+				break;
+			stage_record(STAGE_READ, get_time_us() - read_start_us);
+			snprintf(slot->seq_name, sizeof(slot->seq_name), "%s#%06d", g_video_path, i);
+			slot->src_path = slot->seq_name;
+			slot->frame_id = ++i;
+			slot->push_fd = slot->fd;
+			spsc_push(&inst->filled_ring, slot_idx);
+			continue;
+		}
+
+		// yuvseq容器模式：单文件单次open，按帧偏移定位读取
+		// 多实例时各实例pread自己分片内的帧，定位读取天然线程安全
+		if (g_yuvseq_fd >= 0) {
+			RK_U32 frame_index = inst->file_cursor;
+			inst->file_cursor++;
+			if (inst->file_cursor >= inst->file_end)
+				inst->file_cursor = inst->file_begin;
+			off_t offset = sizeof(YUVSEQ_HEADER_S) + (off_t)frame_index * size;
+			long long read_start_us = get_time_us();
+			s32Ret = pread(g_yuvseq_fd, slot->vaddr, size, offset);
+			__sync_fetch_and_add(&g_audit_file_syscalls, 1);
+			if (s32Ret != (RK_S32)size) {
+				RK_LOGE("pread yuvseq frame %u failed, got %d", frame_index, s32Ret);
+				memset(slot->vaddr, 0, size);
+			}
+			long long read_done_us = get_time_us();
+			stage_record(STAGE_READ, read_done_us - read_start_us);
+			RK_MPI_SYS_MmzFlushCache(slot->blk, RK_FALSE);
+			stage_record(STAGE_FLUSH, get_time_us() - read_done_us);
+			// 帧名已在打开容器时预格式化，稳态无每帧snprintf
+			if (g_yuvseq_names) {
+				slot->src_path = g_yuvseq_names[frame_index];
+			} else {
+				snprintf(slot->seq_name, sizeof(slot->seq_name), "%s#%06u", path, frame_index);
+				slot->src_path = slot->seq_name;
+			}
+			slot->frame_id = ++i;
+			slot->push_fd = slot->fd;
+			spsc_push(&inst->filled_ring, slot_idx);
+			continue;
+		}
+
+		// 根据模式选择文件路径
+		char *current_file_path = NULL;
+		RK_S32 list_index = -1;
+		if (g_worker_fd >= 0 && yuv_files && yuv_file_count > 0) {
+			// 工作端模式：文件下标由协调端批量下发，领不到说明全局扫完
+			RK_S32 widx = worker_next_index();
+			if (widx < 0 || widx >= yuv_file_count) {
+				RK_LOGI("worker: no more work after %d frames", i);
+				// 槽位就地放弃，不回塞recycle_ring（生产者只能是释放回调）
+				break;
+			}
+			list_index = widx;
+			current_file_path = yuv_files[widx];
+			inst->files_read++;
+		} else if (yuv_files && yuv_file_count > 0) {
+		    // 目录模式：循环使用本实例分片内的文件
+		    list_index = inst->file_cursor;
+		    current_file_path = yuv_files[list_index];
+		    inst->file_cursor++;
+		    if (inst->file_cursor >= inst->file_end)
+		        inst->file_cursor = inst->file_begin;
+		    // 通知预读线程推进
+		    inst->files_read++;
+		    RK_LOGI("inst %d reading file: %s", inst->inst_id, current_file_path);
+		} else if (path) {
+		    // 单文件模式
+		    current_file_path = path;
+		}
+
+		// 预载命中：直接推送缓存块的fd，零磁盘IO零拷贝
+		// （前处理模式下缓存块是原始分辨率，不能直推，走读取路径）
+		if (g_preload_enable && !g_input_width && list_index >= 0 &&
+		    list_index < g_preload_count) {
+			slot->src_path = current_file_path;
+			slot->frame_id = ++i;
+			slot->push_fd = g_preload_entries[list_index].fd;
+			spsc_push(&inst->filled_ring, slot_idx);
+			continue;
+		}
+
+		// 打开并读取当前图像文件到槽位的DMA缓冲
+		RK_S32 load_ret = RK_FAILURE;
+		long long read_start_us = get_time_us();
+		if (current_file_path && g_use_mmap_input) {
+			// mmap输入模式：映射文件并做单次cache一致拷贝
+			load_ret = load_frame_mmap(slot, current_file_path, read_size,
+			                           inst->iva_ctx.u32ImageWidth,
+			                           inst->iva_ctx.u32ImageHeight);
+			// open/mmap/munmap/close各一次
+			__sync_fetch_and_add(&g_audit_file_syscalls, 4);
+			if (load_ret == RK_SUCCESS)
+				stage_record(STAGE_READ, get_time_us() - read_start_us);
+		} else if (current_file_path) {
+			RK_S32 input_file_fd = open(current_file_path, O_RDONLY);
+			if (input_file_fd >= 0) {
+				// 前处理模式先读进暂存缓冲，缩放/裁剪后再进DMA槽位
+				void *read_dst = g_input_width ? (void *)inst->pre_buf : slot->vaddr;
+				s32Ret = read(input_file_fd, read_dst, read_size);
+				RK_LOGI("input image size %d from %s", s32Ret, current_file_path);
+				if (g_input_width)
+					nv12_preprocess(inst->pre_buf, (RK_U8 *)slot->vaddr,
+					                inst->iva_ctx.u32ImageWidth,
+					                inst->iva_ctx.u32ImageHeight);
+				long long read_done_us = get_time_us();
+				stage_record(STAGE_READ, read_done_us - read_start_us);
+				RK_MPI_SYS_MmzFlushCache(slot->blk, RK_FALSE);
+				stage_record(STAGE_FLUSH, get_time_us() - read_done_us);
+				close(input_file_fd);
+				// open/read/close各一次
+				__sync_fetch_and_add(&g_audit_file_syscalls, 3);
+				load_ret = RK_SUCCESS;
+			} else {
+				__sync_fetch_and_add(&g_audit_file_syscalls, 1);
+				RK_LOGE("open %s failed because %s", current_file_path, strerror(errno));
+			}
+		}
+
+		if (load_ret != RK_SUCCESS) {
+			RK_LOGE("load %s failed, use empty image as input",
+			        current_file_path ? current_file_path : "null");
+			memset(slot->vaddr, 0, size);
+			RK_MPI_SYS_MmzFlushCache(slot->blk, RK_FALSE);
+		}
+
+		slot->src_path = current_file_path;
+		slot->frame_id = ++i;
+		slot->push_fd = slot->fd;
+		// 通知提交线程本槽位已装载完成
+		spsc_push(&inst->filled_ring, slot_idx);
+	}
+
+	// 先收工再退出，提交线程把环排空后不再等新帧
+	inst->reader_done = 1;
+	RK_LOGI("read_frame_thread (inst %d) exit !!!", inst->inst_id);
+	return RK_NULL;
 }
 
 // 向IVA发送帧数据的线程函数
 static void *send_frame_to_iva_thread(void *pArgs) {
+	IVA_INSTANCE_S *inst = (IVA_INSTANCE_S *)pArgs;
 	prctl(PR_SET_NAME, "send_frame_to_iva_thread");
+	pipeline_thread_tune(inst->inst_id);
 	RK_S32 s32Ret = RK_FAILURE;
-	RK_S32 input_file_fd = -1;
 	RockIvaImage input_image;
-	RK_U32 size = iva_ctx.u32ImageWidth * iva_ctx.u32ImageHeight * 3 / 2;
+	RK_U32 size = inst->iva_ctx.u32ImageWidth * inst->iva_ctx.u32ImageHeight * 3 / 2;
 	RK_S32 i = 0;
-	RK_S32 pool_id;
 	MB_POOL_CONFIG_S pool_cfg;
-	MB_BLK blk;
-	void *input_image_vaddr;
-	RK_S32 input_image_fd;
-	struct timespec iva_start_time, iva_end_time;
-	long delay_time = (1000 / iva_ctx.u32IvaDetectFrameRate);
+	long delay_time = (1000 / inst->iva_ctx.u32IvaDetectFrameRate);
 	long cost_time = 0;
+	// 批量提交状态：批内帧计数与批次起始时间
+	RK_S32 batch_fill = 0;
+	long long batch_start_us = 0;
+	// 实时档状态：单帧耗时的EWMA（毫秒，-1表示未初始化）与时间轴原点
+	long ewma_cost = -1;
+	long long realtime_epoch_us = 0;
 
-	// 初始化内存池配置
-	memset(&pool_cfg, 0, sizeof(MB_POOL_CONFIG_S));
-	pool_cfg.u64MBSize = size;
-	pool_cfg.u32MBCnt = 1;
-	pool_cfg.enAllocType = MB_ALLOC_TYPE_DMA;
-	pool_cfg.bPreAlloc = RK_FALSE;
-	
-	// 创建内存池
-	pool_id = RK_MPI_MB_CreatePool(&pool_cfg);
-	if (pool_id == MB_INVALID_POOLID) {
-		RK_LOGE("create mb pool failed");
+	// 创建内存池和槽位（任务队列复用时上一任务已留下同尺寸的池）
+	if (!inst->slots) {
+		// 初始化内存池配置：按流水线深度分配多块DMA缓冲
+		memset(&pool_cfg, 0, sizeof(MB_POOL_CONFIG_S));
+		pool_cfg.u64MBSize = size;
+		pool_cfg.u32MBCnt = g_pipeline_depth;
+		pool_cfg.enAllocType = MB_ALLOC_TYPE_DMA;
+		pool_cfg.bPreAlloc = RK_FALSE;
+
+		// 创建内存池
+		inst->pool_id = RK_MPI_MB_CreatePool(&pool_cfg);
+		if (inst->pool_id == MB_INVALID_POOLID) {
+			RK_LOGE("create mb pool failed");
+			program_handle_error(__func__, __LINE__);
+			return NULL;
+		}
+
+		// 分配槽位数组并为每个槽位获取内存块
+		inst->slots = (FRAME_SLOT_S *)calloc(g_pipeline_depth, sizeof(FRAME_SLOT_S));
+		if (!inst->slots) {
+			RK_LOGE("allocate frame slots failed");
+			program_handle_error(__func__, __LINE__);
+			return NULL;
+		}
+		for (i = 0; i < g_pipeline_depth; i++) {
+			inst->slots[i].blk = RK_MPI_MB_GetMB(inst->pool_id, size, RK_TRUE);
+			if (inst->slots[i].blk == MB_INVALID_HANDLE) {
+				RK_LOGE("get mb block %d failed", i);
+				program_handle_error(__func__, __LINE__);
+				return NULL;
+			}
+			inst->slots[i].vaddr = RK_MPI_MB_Handle2VirAddr(inst->slots[i].blk);
+			inst->slots[i].fd = RK_MPI_MB_Handle2Fd(inst->slots[i].blk);
+		}
+		// 帧池占用记账，随阶段统计导出
+		__sync_fetch_and_add(&g_mem_pool_bytes, (long long)size * g_pipeline_depth);
+
+		// 前处理暂存缓冲（普通堆内存即可，NPU不直接访问）
+		if (g_input_width) {
+			inst->pre_buf = (RK_U8 *)malloc((size_t)g_input_width *
+			                                g_input_height * 3 / 2);
+			if (!inst->pre_buf) {
+				RK_LOGE("allocate preprocess buffer failed");
+				program_handle_error(__func__, __LINE__);
+				return NULL;
+			}
+		}
+	}
+
+	// 在途文件FIFO，容量取流水线深度的两倍以留余量
+	inst->inflight_cap = g_pipeline_depth * 2;
+	inst->inflight_paths = (char **)calloc(inst->inflight_cap, sizeof(char *));
+	inst->inflight_frame_ids = (RK_U32 *)calloc(inst->inflight_cap, sizeof(RK_U32));
+	inst->inflight_push_us = (long long *)calloc(inst->inflight_cap, sizeof(long long));
+
+	// 基准模式：预分配延迟样本数组，回调中只做一次下标写入
+	if (g_benchmark_mode) {
+		inst->lat_cap = (inst->loop_count > 0) ? (RK_U32)inst->loop_count : (1 << 20);
+		inst->lat_samples = (long *)malloc(inst->lat_cap * sizeof(long));
+		inst->lat_count = 0;
+	}
+	inst->bench_start_ms = get_time_ms();
+
+	// 初始化无锁环：回收环预填所有槽位下标（开始时全部空闲）
+	if (spsc_init(&inst->recycle_ring, g_pipeline_depth + 1) != RK_SUCCESS ||
+	    spsc_init(&inst->filled_ring, g_pipeline_depth + 1) != RK_SUCCESS) {
+		RK_LOGE("init spsc rings failed");
 		program_handle_error(__func__, __LINE__);
 		return NULL;
 	}
-	
-	// 获取内存块
-	blk = RK_MPI_MB_GetMB(pool_id, size, RK_TRUE);
-	if (blk == MB_INVALID_HANDLE) {
-		RK_LOGE("get mb block failed");
-		program_handle_error(__func__, __LINE__);
-		return NULL;
+	for (i = 0; i < g_pipeline_depth; i++)
+		spsc_push(&inst->recycle_ring, i);
+	inst->release_seq = 0;
+	RK_LOGI("inst %d loop count %d\n", inst->inst_id, inst->loop_count);
+
+	// 启动读文件线程，与本线程的提交流水线并行
+	pthread_create(&inst->read_thread_id, 0, read_frame_thread, inst);
+
+	// 目录冷读模式才需要预读：预载/yuvseq/视频模式下没有逐文件read()
+	RK_S32 use_readahead = g_readahead_depth > 0 && yuv_files && yuv_file_count > 0 &&
+	                       !g_preload_enable && g_yuvseq_fd < 0 && !g_vdec_inited;
+	if (use_readahead)
+		pthread_create(&inst->readahead_thread_id, 0, readahead_thread, inst);
+
+	// 主循环：向IVA发送图像帧进行处理
+	i = 0;
+	__sync_fetch_and_add(&g_active_senders, 1);
+	realtime_epoch_us = get_time_us();
+	while (!quit && (inst->loop_count < 0 || i < inst->loop_count)) {
+		// 模型热重载：停在暂停点不再推帧，主线程换完IVA上下文后放行。
+		// 读文件线程无需配合：环填满后自然阻塞在回收环上
+		if (g_reload_pause) {
+			__sync_fetch_and_add(&g_paused_senders, 1);
+			while (g_reload_pause && !quit)
+				usleep(1000);
+			__sync_fetch_and_sub(&g_paused_senders, 1);
+			continue;
+		}
+		// 等待读文件线程装载好下一帧（读线程收工且环已空则结束，
+		// 实时跳帧会提前耗尽循环额度，实际帧数少于loop_count）
+		RK_U32 slot_idx;
+		if (spsc_pop_spin_stop(&inst->filled_ring, &slot_idx,
+		                       &inst->reader_done) != RK_SUCCESS)
+			break;
+
+		FRAME_SLOT_S *slot = &inst->slots[slot_idx];
+		RK_LOGI("inst %d loop count %d", inst->inst_id, i++);
+		// 批次的第一帧记下起始时间，限速按整批计算
+		if (batch_fill == 0)
+			batch_start_us = get_time_us();
+
+		// 发送图像帧到IVA进行处理
+		input_image.info.transformMode = inst->iva_ctx.eImageTransform;
+		input_image.info.width = inst->iva_ctx.u32ImageWidth;
+		input_image.info.height = inst->iva_ctx.u32ImageHeight;
+		input_image.info.format = inst->iva_ctx.eImageFormat;
+		input_image.frameId = slot->frame_id;
+		input_image.dataAddr = NULL;
+		input_image.dataPhyAddr = NULL;
+		input_image.dataFd = slot->push_fd;
+
+		// 先登记在途FIFO再提交，确保结果回调到来时一定能查到本帧
+		long long push_start_us = get_time_us();
+		inst->inflight_paths[inst->inflight_wr % inst->inflight_cap] = slot->src_path;
+		inst->inflight_frame_ids[inst->inflight_wr % inst->inflight_cap] = slot->frame_id;
+		inst->inflight_push_us[inst->inflight_wr % inst->inflight_cap] = push_start_us;
+		inst->inflight_wr++;
+
+		s32Ret = ROCKIVA_PushFrame(inst->iva_ctx.ivahandle, &input_image, NULL);
+		stage_record(STAGE_PUSH, get_time_us() - push_start_us);
+		if (s32Ret < 0) {
+			RK_LOGE("ROCKIVA_PushFrame failed %#X", s32Ret);
+			program_handle_error(__func__, __LINE__);
+			break;
+		}
+		inst->frames_pushed++;
+		batch_fill++;
+
+		// 在途DMA缓冲水位：各实例(pushed-released)求和后推高峰值。
+		// 并发更新不加锁，偶发少记一次无碍水位判断
+		RK_U32 inflight = 0;
+		for (RK_S32 m = 0; m < g_instance_count; m++) {
+			RK_U32 p = g_instances[m].frames_pushed;
+			RK_U32 r = g_instances[m].frames_released;
+			if (p > r)
+				inflight += p - r;
+		}
+		if (inflight > g_mem_inflight_peak)
+			g_mem_inflight_peak = inflight;
+
+		// 攒满一批后才统一限速：批内各帧背靠背提交，
+		// NPU命令队列保持非空（推理与下一帧读取此时并行进行）
+		if (batch_fill >= g_batch_size) {
+			long batch_budget = delay_time * batch_fill;
+			cost_time = (long)((get_time_us() - batch_start_us) / 1000);
+			RK_LOGI("iva submit batch of %d cost %ld ms, delay for %ld ms", batch_fill,
+			        cost_time, batch_budget > cost_time ? (batch_budget - cost_time) : 0);
+			// 实时档：跟踪单帧耗时的EWMA（1/8步长），EWMA超出帧预算且
+			// 实际进度落后理想时间轴超过一帧时，请求读线程跳帧追平。
+			// 静态的delay_time假设NPU永远跟得上，降频时只会越跑越晚
+			if (g_realtime_mode && delay_time > 0) {
+				long per_frame = cost_time / batch_fill;
+				ewma_cost = (ewma_cost < 0) ? per_frame
+				                            : (ewma_cost * 7 + per_frame) / 8;
+				long long ideal_us = realtime_epoch_us +
+				    (long long)(inst->frames_pushed + inst->frames_skipped) *
+				        delay_time * 1000;
+				long lag_ms = (long)((get_time_us() - ideal_us) / 1000);
+				if (ewma_cost > delay_time && lag_ms > delay_time) {
+					RK_S32 n_skip = (RK_S32)(lag_ms / delay_time);
+					__sync_fetch_and_add(&inst->skip_request, n_skip);
+					RK_LOGI("inst %d realtime: ewma %ld ms over budget %ld ms, "
+					        "lag %ld ms, skip %d frames",
+					        inst->inst_id, ewma_cost, delay_time, lag_ms, n_skip);
+				}
+			}
+			// 基准模式关闭限速，满速提交以测量硬件真实吞吐
+			if (!g_benchmark_mode && batch_budget > cost_time)
+				usleep((batch_budget - cost_time) * 1000);
+			batch_fill = 0;
+		}
+	}
+
+	// 退出提交循环后不再经过热重载暂停点，从等待名单里摘除
+	__sync_fetch_and_sub(&g_active_senders, 1);
+
+	// 自然跑完（非quit打断）才算完成，断点文件据此决定去留；
+	// 实时档跳过的帧也计入进度，丢帧跑完同样算完成
+	if (inst->loop_count >= 0 &&
+	    i + (RK_S32)inst->frames_skipped >= inst->loop_count)
+		inst->run_complete = 1;
+
+	// 等待所有在途帧被IVA释放（最多等1秒，防止异常时卡死）
+	for (i = 0; i < 1000 && inst->frames_released < inst->frames_pushed; i++)
+		usleep(1000);
+	if (inst->frames_released < inst->frames_pushed)
+		RK_LOGE("inst %d wait inflight frames timeout, pushed %u released %u",
+		        inst->inst_id, inst->frames_pushed, inst->frames_released);
+
+	// 回收读文件线程；自旋弹出会自行感知quit退出，无需补发唤醒
+	pthread_join(inst->read_thread_id, RK_NULL);
+	if (use_readahead) {
+		inst->readahead_stop = 1;
+		pthread_join(inst->readahead_thread_id, RK_NULL);
+	}
+
+	// 清理资源（任务队列要复用上下文时槽位和内存池留给下一个任务）
+	spsc_deinit(&inst->recycle_ring);
+	spsc_deinit(&inst->filled_ring);
+	if (!g_job_keep_ctx) {
+		for (i = 0; i < g_pipeline_depth; i++) {
+			if (inst->slots[i].blk != MB_INVALID_HANDLE)
+				RK_MPI_MB_ReleaseMB(inst->slots[i].blk);
+		}
+		free(inst->slots);
+		inst->slots = NULL;
+		free(inst->pre_buf);
+		inst->pre_buf = NULL;
+		RK_MPI_MB_DestroyPool(inst->pool_id);
+		__sync_fetch_and_sub(&g_mem_pool_bytes, (long long)size * g_pipeline_depth);
+	}
+	free(inst->inflight_paths);
+	inst->inflight_paths = NULL;
+	free(inst->inflight_frame_ids);
+	inst->inflight_frame_ids = NULL;
+	free(inst->inflight_push_us);
+	inst->inflight_push_us = NULL;
+	if (g_realtime_mode && inst->frames_skipped > 0)
+		RK_LOGI("inst %d realtime: skipped %u frames to keep up", inst->inst_id,
+		        inst->frames_skipped);
+	// 全部实例都完成后才触发正常退出，避免先结束的实例打断其他实例
+	if (__sync_add_and_fetch(&g_instances_done, 1) == g_instance_count)
+		program_normal_exit(__func__, __LINE__);
+	RK_LOGI("send_frame_to_iva_thread (inst %d) exit !!!", inst->inst_id);
+	return RK_NULL;
+}
+
+// qsort比较函数：long升序
+static int compare_long(const void *a, const void *b) {
+	long la = *(const long *)a;
+	long lb = *(const long *)b;
+	return (la > lb) - (la < lb);
+}
+
+// 把当前进度原子落盘：先写.tmp再rename替换，任何时刻崩溃
+// sidecar要么是旧断点要么是新断点，不会是半个
+static void ckpt_write(void) {
+	char tmp_path[sizeof(g_ckpt_path) + 8];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", g_ckpt_path);
+	FILE *fp = fopen(tmp_path, "w");
+	if (!fp)
+		return;
+
+	// 先把结果缓冲刷进文件，断点偏移才和已完成帧数对得上；
+	// 计数快照取自同一临界区，done数不会包含偏移之后才落盘的帧
+	long long offset = 0;
+	RK_U32 done[CKPT_MAX_INST];
+	RK_S32 done_count =
+	    g_instance_count < CKPT_MAX_INST ? g_instance_count : CKPT_MAX_INST;
+	pthread_mutex_lock(&g_result_file_mutex);
+	if (result_output_file) {
+		if (g_result_format_bin)
+			result_bin_flush();
+		fflush(result_output_file);
+		offset = (long long)ftello(result_output_file);
+	}
+	for (RK_S32 k = 0; k < done_count; k++)
+		done[k] = g_instances[k].results_received;
+	pthread_mutex_unlock(&g_result_file_mutex);
+
+	fprintf(fp, "offset %lld\n", offset);
+	for (RK_S32 k = 0; k < done_count; k++)
+		fprintf(fp, "inst %d done %u\n", k, done[k]);
+	fflush(fp);
+	fsync(fileno(fp));
+	fclose(fp);
+	rename(tmp_path, g_ckpt_path);
+}
+
+// 读取sidecar；读不到就当没有断点，从头开始
+static RK_S32 ckpt_load(void) {
+	FILE *fp = fopen(g_ckpt_path, "r");
+	if (!fp)
+		return RK_FAILURE;
+
+	char line[128];
+	RK_S32 idx;
+	RK_U32 done;
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "offset %lld", &g_ckpt_result_offset) == 1)
+			continue;
+		if (sscanf(line, "inst %d done %u", &idx, &done) == 2 &&
+		    idx >= 0 && idx < CKPT_MAX_INST)
+			g_ckpt_done[idx] = done;
+	}
+	fclose(fp);
+	g_ckpt_loaded = 1;
+	RK_LOGI("checkpoint loaded from %s, result offset %lld",
+	        g_ckpt_path, g_ckpt_result_offset);
+	return RK_SUCCESS;
+}
+
+// 输出稳态审计结果：每帧文件系统调用数和稳态后的堆增量（期望为0）
+static void audit_report(void) {
+	RK_U64 frames = 0;
+	for (RK_S32 k = 0; k < g_instance_count; k++)
+		frames += g_instances[k].frames_pushed;
+
+	printf("audit: %llu frames, %llu file syscalls (%.2f per frame)\n",
+	       (unsigned long long)frames,
+	       (unsigned long long)g_audit_file_syscalls,
+	       frames ? (double)g_audit_file_syscalls / frames : 0.0);
+
+	if (g_audit_baseline_taken) {
+		size_t heap_now = (size_t)mallinfo().uordblks;
+		long long growth = (long long)heap_now - (long long)g_audit_heap_baseline;
+		printf("audit: heap in use %zu bytes, growth since steady state %lld bytes%s\n",
+		       heap_now, growth, growth > 0 ? " (expected 0)" : "");
+	}
+}
+
+// 输出基准统计：各实例及汇总的吞吐与延迟分位数
+// 基准套件（--bench_suite 清单，配合--golden 黄金目录）：按任务清单
+// 格式跑一轮基准（隐含--benchmark与二进制结果格式），每个任务落一个
+// 紧凑的二进制结果文件和.perf性能基线；--golden指向上一版模型用同一
+// 清单跑出的输出目录时，逐帧对比检测结果并汇总性能差异。两个多GB
+// 文本文件的人工对比从此变成几分钟的自动回归。多实例下记录顺序
+// 不保证稳定，套件清单建议按单实例配置
+static char *g_bench_suite_path = NULL;
+static char *g_golden_dir = NULL;
+// 当前任务的基准数据，benchmark_report算完后登记在这里供套件取用
+static double g_bench_fps = 0.0;
+static long g_bench_p99 = 0;
+
+static void benchmark_report(void) {
+	RK_U32 total_frames = 0;
+	RK_U32 total_samples = 0;
+	long *all_samples = NULL;
+	long span_ms = 0;
+
+	for (RK_S32 k = 0; k < g_instance_count; k++)
+		total_samples += g_instances[k].lat_count;
+	if (total_samples == 0) {
+		printf("benchmark: no latency samples collected\n");
+		return;
+	}
+
+	all_samples = (long *)malloc(total_samples * sizeof(long));
+	if (!all_samples)
+		return;
+
+	RK_U32 pos = 0;
+	for (RK_S32 k = 0; k < g_instance_count; k++) {
+		IVA_INSTANCE_S *inst = &g_instances[k];
+		long inst_span = inst->last_result_ms - inst->bench_start_ms;
+		total_frames += inst->results_received;
+		if (inst_span > span_ms)
+			span_ms = inst_span;
+		printf("benchmark inst %d: %u frames in %ld ms (%.2f fps)\n",
+		       inst->inst_id, inst->results_received, inst_span,
+		       inst_span > 0 ? inst->results_received * 1000.0 / inst_span : 0.0);
+		memcpy(all_samples + pos, inst->lat_samples, inst->lat_count * sizeof(long));
+		pos += inst->lat_count;
+		free(inst->lat_samples);
+		inst->lat_samples = NULL;
+	}
+
+	qsort(all_samples, total_samples, sizeof(long), compare_long);
+	printf("benchmark total: %u frames in %ld ms (%.2f fps)\n", total_frames, span_ms,
+	       span_ms > 0 ? total_frames * 1000.0 / span_ms : 0.0);
+	printf("benchmark latency: p50 %ld ms, p95 %ld ms, p99 %ld ms, max %ld ms\n",
+	       all_samples[total_samples * 50 / 100],
+	       all_samples[total_samples * 95 / 100],
+	       all_samples[total_samples * 99 / 100],
+	       all_samples[total_samples - 1]);
+	// 登记给基准套件做黄金对比
+	g_bench_fps = span_ms > 0 ? total_frames * 1000.0 / span_ms : 0.0;
+	g_bench_p99 = all_samples[total_samples * 99 / 100];
+	free(all_samples);
+}
+
+// 写性能基线sidecar，黄金目录里的同名.perf文件用于对比
+static void bench_perf_write(const char *output_path) {
+	char perf_path[512];
+	snprintf(perf_path, sizeof(perf_path), "%s.perf", output_path);
+	FILE *fp = fopen(perf_path, "w");
+	if (!fp) {
+		RK_LOGE("open %s failed because %s", perf_path, strerror(errno));
+		return;
+	}
+	fprintf(fp, "fps %.2f\np99 %ld\n", g_bench_fps, g_bench_p99);
+	fclose(fp);
+}
+
+// 对比时每帧最多细看的对象数（超出部分只计入objNum差异）
+#define BENCH_DIFF_MAX_OBJS 128
+
+// 从二进制结果文件读一条帧记录及其对象，流结束或截断返回失败
+static RK_S32 bin_read_frame(FILE *fp, RESULT_BIN_FRAME_S *frame,
+                             RESULT_BIN_OBJ_S *objs, RK_U32 max_objs) {
+	if (fread(frame, sizeof(*frame), 1, fp) != 1)
+		return RK_FAILURE;
+	for (RK_U32 n = 0; n < frame->obj_num; n++) {
+		RESULT_BIN_OBJ_S tmp;
+		if (fread(&tmp, sizeof(tmp), 1, fp) != 1)
+			return RK_FAILURE;
+		if (n < max_objs)
+			objs[n] = tmp;
+	}
+	return RK_SUCCESS;
+}
+
+// 与黄金结果逐帧对比：objNum差异、按类别的得分漂移、fps/p99变化
+static void bench_diff_job(const char *output_path) {
+	const char *base = strrchr(output_path, '/');
+	base = base ? base + 1 : output_path;
+	char golden_path[512];
+	snprintf(golden_path, sizeof(golden_path), "%s/%s", g_golden_dir, base);
+
+	FILE *cur = fopen(output_path, "rb");
+	FILE *gold = fopen(golden_path, "rb");
+	if (!cur || !gold) {
+		RK_LOGE("bench diff: open %s failed because %s",
+		        cur ? golden_path : output_path, strerror(errno));
+		if (cur)
+			fclose(cur);
+		if (gold)
+			fclose(gold);
+		return;
+	}
+
+	RESULT_BIN_HEADER_S hc, hg;
+	if (fread(&hc, sizeof(hc), 1, cur) != 1 || fread(&hg, sizeof(hg), 1, gold) != 1 ||
+	    hc.magic != RESULT_BIN_MAGIC || hg.magic != RESULT_BIN_MAGIC) {
+		RK_LOGE("bench diff: %s or %s is not a bin result file", output_path,
+		        golden_path);
+		fclose(cur);
+		fclose(gold);
+		return;
+	}
+
+	RESULT_BIN_FRAME_S fc, fg;
+	static RESULT_BIN_OBJ_S objs_cur[BENCH_DIFF_MAX_OBJS];
+	static RESULT_BIN_OBJ_S objs_gold[BENCH_DIFF_MAX_OBJS];
+	RK_S32 type_count = (RK_S32)(sizeof(g_type_str) / sizeof(g_type_str[0]));
+	RK_U64 frames = 0;
+	RK_U64 objnum_mismatch = 0;
+	RK_U64 type_matched[sizeof(g_type_str) / sizeof(g_type_str[0])] = {0};
+	long long type_drift[sizeof(g_type_str) / sizeof(g_type_str[0])] = {0};
+
+	while (bin_read_frame(cur, &fc, objs_cur, BENCH_DIFF_MAX_OBJS) == RK_SUCCESS &&
+	       bin_read_frame(gold, &fg, objs_gold, BENCH_DIFF_MAX_OBJS) == RK_SUCCESS) {
+		frames++;
+		if (fc.obj_num != fg.obj_num)
+			objnum_mismatch++;
+		RK_U32 n = fc.obj_num < fg.obj_num ? fc.obj_num : fg.obj_num;
+		if (n > BENCH_DIFF_MAX_OBJS)
+			n = BENCH_DIFF_MAX_OBJS;
+		// 同下标且同类别的对象按类别累计得分漂移
+		for (RK_U32 j = 0; j < n; j++) {
+			RK_S32 t = objs_cur[j].type;
+			if (t != objs_gold[j].type || t < 0 || t >= type_count)
+				continue;
+			type_matched[t]++;
+			type_drift[t] += objs_cur[j].score - objs_gold[j].score;
+		}
+	}
+	fclose(cur);
+	fclose(gold);
+
+	printf("bench diff %s vs %s:\n", output_path, golden_path);
+	printf("  frames compared %llu, objnum mismatches %llu (%.2f%%)\n",
+	       (unsigned long long)frames, (unsigned long long)objnum_mismatch,
+	       frames > 0 ? objnum_mismatch * 100.0 / frames : 0.0);
+	for (RK_S32 t = 0; t < type_count; t++)
+		if (type_matched[t])
+			printf("  %-12s %llu objs, avg score drift %+.2f\n", g_type_str[t],
+			       (unsigned long long)type_matched[t],
+			       (double)type_drift[t] / type_matched[t]);
+
+	// 性能对比：黄金目录同名.perf里的基线 vs 本次
+	char golden_perf[520];
+	snprintf(golden_perf, sizeof(golden_perf), "%s.perf", golden_path);
+	FILE *pf = fopen(golden_perf, "r");
+	if (pf) {
+		double gfps = 0.0;
+		long gp99 = 0;
+		if (fscanf(pf, "fps %lf p99 %ld", &gfps, &gp99) == 2 && gfps > 0.0)
+			printf("  fps %.2f -> %.2f (%+.1f%%), p99 %ld -> %ld ms (%+.1f%%)\n",
+			       gfps, g_bench_fps, (g_bench_fps - gfps) * 100.0 / gfps, gp99,
+			       g_bench_p99,
+			       gp99 > 0 ? (double)(g_bench_p99 - gp99) * 100.0 / gp99 : 0.0);
+		fclose(pf);
+	} else {
+		printf("  no golden perf baseline at %s\n", golden_perf);
+	}
+}
+
+// 协调端状态：全局派发游标与在线工作端计数。连接fd和线程id记在
+// 表里（只有accept循环写），SIGINT时shutdown各fd把阻塞的read踢醒，
+// 合并输出必须等全部连接线程join之后才能关闭
+#define COORD_MAX_WORKERS 32
+static RK_S32 g_coord_cursor = 0;
+static pthread_mutex_t g_coord_grant_mutex = PTHREAD_MUTEX_INITIALIZER;
+static volatile RK_S32 g_coord_active_conns = 0;
+static RK_S32 g_coord_conn_fds[COORD_MAX_WORKERS];
+static pthread_t g_coord_conn_tids[COORD_MAX_WORKERS];
+static RK_S32 g_coord_conn_count = 0;
+
+// 未完成批次补发队列：工作端中途断开时，已派发但结果没回流的文件
+// 区间放回这里，后续REQ优先从队列领，不再凭游标走完就当全部完成。
+// 结果按派发顺序回流（工作端是单实例FIFO流水线），断开时按已回流
+// 帧数从区间台账前端抵扣，剩下的就是丢失区间
+typedef struct {
+	RK_S32 begin;
+	RK_S32 count;
+} COORD_RANGE_S;
+#define COORD_REQUEUE_MAX 1024
+static COORD_RANGE_S g_coord_requeue[COORD_REQUEUE_MAX];
+static RK_S32 g_coord_requeue_count = 0;
+static RK_S32 g_coord_requeue_lost = 0;  // 补发队列溢出而放弃的文件数
+static volatile RK_S32 g_coord_frames_merged = 0;  // 已并入输出的帧记录数
+
+// 领取下一批：补发队列优先，其次推进全局游标（大区间拆成整批领走）
+static void coord_take_batch(RK_S32 *begin, RK_S32 *count) {
+	pthread_mutex_lock(&g_coord_grant_mutex);
+	if (g_coord_requeue_count > 0) {
+		COORD_RANGE_S *r = &g_coord_requeue[g_coord_requeue_count - 1];
+		*begin = r->begin;
+		*count = r->count > COORD_BATCH_FILES ? COORD_BATCH_FILES : r->count;
+		r->begin += *count;
+		r->count -= *count;
+		if (r->count == 0)
+			g_coord_requeue_count--;
+	} else {
+		*begin = g_coord_cursor;
+		*count = yuv_file_count - *begin;
+		if (*count > COORD_BATCH_FILES)
+			*count = COORD_BATCH_FILES;
+		if (*count < 0)
+			*count = 0;
+		g_coord_cursor += *count;
+	}
+	pthread_mutex_unlock(&g_coord_grant_mutex);
+}
+
+// 把没完成的区间放回补发队列
+static void coord_requeue_range(RK_S32 begin, RK_S32 count) {
+	pthread_mutex_lock(&g_coord_grant_mutex);
+	if (g_coord_requeue_count < COORD_REQUEUE_MAX) {
+		g_coord_requeue[g_coord_requeue_count].begin = begin;
+		g_coord_requeue[g_coord_requeue_count].count = count;
+		g_coord_requeue_count++;
+	} else {
+		g_coord_requeue_lost += count;
+	}
+	pthread_mutex_unlock(&g_coord_grant_mutex);
+}
+
+// 补发队列里还压着的文件数（对账日志用）
+static RK_S32 coord_requeue_pending(void) {
+	RK_S32 pending = 0;
+	pthread_mutex_lock(&g_coord_grant_mutex);
+	for (RK_S32 r = 0; r < g_coord_requeue_count; r++)
+		pending += g_coord_requeue[r].count;
+	pthread_mutex_unlock(&g_coord_grant_mutex);
+	return pending;
+}
+
+// 协调端连接线程：一个工作端一条连接。REQ按全局游标批量下发，慢板子
+// 领得少快板子领得多，负载自动均衡；RESULT负载原样追加进合并输出
+// （记录自带inst_id/frame_id，无需改写）
+static void *coordinator_conn_thread(void *pArgs) {
+	RK_S32 fd = (RK_S32)(long)pArgs;
+	prctl(PR_SET_NAME, "coordinator_conn_thread");
+	COORD_MSG_S msg;
+	RK_U8 *payload = (RK_U8 *)malloc(RESULT_BIN_BUF_SIZE);
+	if (!payload) {
+		RK_LOGE("allocate worker payload buffer failed");
+		shutdown(fd, SHUT_RDWR);
+		__sync_fetch_and_sub(&g_coord_active_conns, 1);
+		return RK_NULL;
+	}
+
+	// 本连接的派发台账：领走的区间与帧数对账，断开时补发没回流的部分
+	COORD_RANGE_S *granted = NULL;
+	RK_S32 granted_count = 0;
+	RK_S32 granted_cap = 0;
+	RK_S32 frames_granted = 0;
+	RK_S32 frames_merged = 0;
+
+	while (!quit) {
+		if (coord_read_full(fd, &msg, sizeof(msg)) != RK_SUCCESS)
+			break;  // 工作端收工断开
+		if (msg.magic != COORD_MSG_MAGIC) {
+			RK_LOGE("bad message magic %#x from worker", msg.magic);
+			break;
+		}
+		if (msg.type == COORD_MSG_WORK_REQ) {
+			RK_S32 begin = 0;
+			RK_S32 count = 0;
+			coord_take_batch(&begin, &count);
+			if (count > 0) {
+				if (granted_count >= granted_cap) {
+					RK_S32 new_cap = granted_cap > 0 ? granted_cap * 2 : 64;
+					COORD_RANGE_S *p = (COORD_RANGE_S *)realloc(
+					    granted, new_cap * sizeof(COORD_RANGE_S));
+					if (!p) {
+						// 台账断档就没法对账了，把这批退回并断开连接
+						RK_LOGE("grow grant ledger failed");
+						coord_requeue_range(begin, count);
+						break;
+					}
+					granted = p;
+					granted_cap = new_cap;
+				}
+				granted[granted_count].begin = begin;
+				granted[granted_count].count = count;
+				granted_count++;
+				frames_granted += count;
+			}
+			COORD_MSG_S grant = {COORD_MSG_MAGIC, COORD_MSG_WORK_GRANT,
+			                     (RK_U32)begin, (RK_U32)count};
+			if (coord_write_full(fd, &grant, sizeof(grant)) != RK_SUCCESS)
+				break;
+		} else if (msg.type == COORD_MSG_RESULT) {
+			if (msg.arg0 > RESULT_BIN_BUF_SIZE) {
+				RK_LOGE("oversized result payload %u from worker", msg.arg0);
+				break;
+			}
+			if (coord_read_full(fd, payload, msg.arg0) != RK_SUCCESS)
+				break;
+			// 清点负载里的帧记录数对账（帧记录后跟obj_num条对象记录）
+			RK_U32 off = 0;
+			RK_S32 frames_in = 0;
+			while (off + sizeof(RESULT_BIN_FRAME_S) <= msg.arg0) {
+				RESULT_BIN_FRAME_S frame_rec;
+				memcpy(&frame_rec, payload + off, sizeof(frame_rec));
+				off += (RK_U32)(sizeof(RESULT_BIN_FRAME_S) +
+				                frame_rec.obj_num * sizeof(RESULT_BIN_OBJ_S));
+				if (off > msg.arg0)
+					break;  // 残缺记录不计
+				frames_in++;
+			}
+			frames_merged += frames_in;
+			__sync_fetch_and_add(&g_coord_frames_merged, frames_in);
+			// 与本地结果路径共用一把锁，整段追加保持记录完整
+			pthread_mutex_lock(&g_result_file_mutex);
+			if (result_output_file)
+				fwrite(payload, 1, msg.arg0, result_output_file);
+			pthread_mutex_unlock(&g_result_file_mutex);
+		} else {
+			RK_LOGE("unknown message type %u from worker", msg.type);
+			break;
+		}
+	}
+
+	// 断开对账：已回流帧数从台账前端抵扣（结果按派发顺序回流），
+	// 抵不完的区间放回补发队列等下一个工作端重做
+	if (frames_merged < frames_granted) {
+		RK_LOGE("worker left %d of %d granted files unfinished, requeue",
+		        frames_granted - frames_merged, frames_granted);
+		RK_S32 consumed = frames_merged;
+		for (RK_S32 g = 0; g < granted_count; g++) {
+			if (consumed >= granted[g].count) {
+				consumed -= granted[g].count;
+				continue;
+			}
+			coord_requeue_range(granted[g].begin + consumed,
+			                    granted[g].count - consumed);
+			consumed = 0;
+		}
+	}
+	free(granted);
+	free(payload);
+	// fd不在这里close：主线程可能还要对它shutdown，join后统一关闭，
+	// 避免fd号被复用后shutdown打到别人头上
+	__sync_fetch_and_sub(&g_coord_active_conns, 1);
+	RK_LOGI("worker connection closed, %d of %d files dispatched so far",
+	        g_coord_cursor, yuv_file_count);
+	return RK_NULL;
+}
+
+// 协调端主循环：建文件索引、开合并输出、监听端口，每个工作端一条
+// 连接线程。索引派完且所有工作端断开后收工。本端不占用NPU
+static RK_S32 run_coordinator(char *directory_path) {
+	if (!directory_path) {
+		RK_LOGE("--coordinator requires -d input directory");
+		return RK_FAILURE;
+	}
+	if (!result_output_path) {
+		RK_LOGE("--coordinator requires -o merged output path");
+		return RK_FAILURE;
+	}
+	if (scan_yuv_directory(directory_path) < 0) {
+		RK_LOGE("Failed to scan directory: %s", directory_path);
+		return RK_FAILURE;
 	}
-	
-	// 获取虚拟地址和文件描述符
-	input_image_vaddr = RK_MPI_MB_Handle2VirAddr(blk);
-	input_image_fd = RK_MPI_MB_Handle2Fd(blk);
 
-	// 初始化信号量
-	sem_init(&g_iva_semaphore, 0, 0);
-	RK_LOGI(" while outside loop count %d\n", loop_count);	
+	result_output_file = fopen(result_output_path, "wb");
+	if (!result_output_file) {
+		RK_LOGE("Failed to open result output file: %s", result_output_path);
+		free_yuv_files();
+		return RK_FAILURE;
+	}
+	RESULT_BIN_HEADER_S bin_header = {RESULT_BIN_MAGIC, RESULT_BIN_VERSION};
+	fwrite(&bin_header, sizeof(bin_header), 1, result_output_file);
 
-	// 主循环：向IVA发送图像帧进行处理
-	while (!quit && (loop_count < 0 || i < loop_count)) { // 修改循环条件
-		RK_LOGI("loop count %d", i++);
-		clock_gettime(CLOCK_MONOTONIC, &iva_start_time);
-		
-		// 根据模式选择文件路径
-		char *current_file_path = NULL;
-		if (yuv_files && yuv_file_count > 0) {
-		    // 目录模式：循环使用目录中的文件
-		    current_file_path = yuv_files[current_file_index];
-		    current_file_index = (current_file_index + 1) % yuv_file_count;
-		    RK_LOGI("Processing file: %s", current_file_path);
-		} else if (path) {
-		    // 单文件模式
-		    current_file_path = path;
-		}
-		
-		// 打开并读取当前图像文件
-		if (current_file_path) {
-		    if (input_file_fd >= 0) {
-		        close(input_file_fd);
-		        input_file_fd = -1;
-		    }
-		    input_file_fd = open(current_file_path, O_RDONLY);
-		}
-		
-		// 读取图像数据到内存
-		if (input_file_fd < 0) {
-			RK_LOGE("open %s failed because %s, use empty image as input", 
-			        current_file_path ? current_file_path : "null", strerror(errno));
-			memset(input_image_vaddr, 0, size);
-			RK_MPI_SYS_MmzFlushCache(blk, RK_FALSE);
-		} else {
-			s32Ret = read(input_file_fd, input_image_vaddr, size);
-			RK_LOGI("input image size %d from %s", s32Ret, current_file_path);
-			RK_MPI_SYS_MmzFlushCache(blk, RK_FALSE);
+	RK_S32 listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd < 0) {
+		RK_LOGE("socket failed because %s", strerror(errno));
+		fclose(result_output_file);
+		result_output_file = NULL;
+		free_yuv_files();
+		return RK_FAILURE;
+	}
+	RK_S32 reuse = 1;
+	setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons((unsigned short)atoi(g_coordinator_port));
+	if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+	    listen(listen_fd, 8) < 0) {
+		RK_LOGE("bind/listen port %s failed because %s", g_coordinator_port,
+		        strerror(errno));
+		close(listen_fd);
+		fclose(result_output_file);
+		result_output_file = NULL;
+		free_yuv_files();
+		return RK_FAILURE;
+	}
+	RK_LOGI("coordinator serving %d files on port %s, merged output %s",
+	        yuv_file_count, g_coordinator_port, result_output_path);
+
+	RK_S32 had_conn = 0;
+	while (!quit) {
+		struct pollfd pfd;
+		pfd.fd = listen_fd;
+		pfd.events = POLLIN;
+		if (poll(&pfd, 1, 500) > 0) {
+			RK_S32 conn_fd = accept(listen_fd, NULL, NULL);
+			if (conn_fd >= 0) {
+				if (g_coord_conn_count >= COORD_MAX_WORKERS) {
+					RK_LOGE("worker limit %d reached, reject connection",
+					        COORD_MAX_WORKERS);
+					close(conn_fd);
+					continue;
+				}
+				had_conn = 1;
+				__sync_fetch_and_add(&g_coord_active_conns, 1);
+				g_coord_conn_fds[g_coord_conn_count] = conn_fd;
+				pthread_create(&g_coord_conn_tids[g_coord_conn_count], 0,
+				               coordinator_conn_thread, (void *)(long)conn_fd);
+				g_coord_conn_count++;
+				RK_LOGI("worker connected, %d active", g_coord_active_conns);
+			}
 		}
-		
-		// 发送图像帧到IVA进行处理
-		input_image.info.transformMode = iva_ctx.eImageTransform;
-		input_image.info.width = iva_ctx.u32ImageWidth;
-		input_image.info.height = iva_ctx.u32ImageHeight;
-		input_image.info.format = iva_ctx.eImageFormat;
-		input_image.frameId = i;
-		input_image.dataAddr = NULL;
-		input_image.dataPhyAddr = NULL;
-		input_image.dataFd = input_image_fd;
-		s32Ret = ROCKIVA_PushFrame(iva_ctx.ivahandle, &input_image, NULL);
-		if (s32Ret < 0) {
-			RK_LOGE("ROCKIVA_PushFrame failed %#X", s32Ret);
-			program_handle_error(__func__, __LINE__);
+		// 索引派完、补发队列清空且工作端都断开才收工；队列里还压着
+		// 区间就继续守着端口等新工作端来领，操作员可Ctrl-C放弃
+		if (had_conn && g_coord_active_conns == 0 &&
+		    g_coord_cursor >= yuv_file_count && g_coord_requeue_count == 0)
 			break;
-		}
-		
-		// 等待IVA处理完成
-		sem_wait(&g_iva_semaphore);
+	}
+	close(listen_fd);
 
-		// 计算处理时间和延迟
-		clock_gettime(CLOCK_MONOTONIC, &iva_end_time);
-		cost_time = (iva_end_time.tv_sec * 1000L + iva_end_time.tv_nsec / 1000000L) -
-		            (iva_start_time.tv_sec * 1000L + iva_start_time.tv_nsec / 1000000L);
-		RK_LOGI("iva cost time %ld ms, delay for %ld ms", cost_time,
-		        delay_time > cost_time ? (delay_time - cost_time) : 0);
-		if (delay_time > cost_time)
-			usleep((delay_time - cost_time) * 1000);
+	// SIGINT打断时连接线程还阻塞在read上，shutdown让它们立刻返回；
+	// 全部join回收后才能动合并输出，否则RESULT晚到一步就写进已关闭的文件
+	for (RK_S32 c = 0; c < g_coord_conn_count; c++)
+		shutdown(g_coord_conn_fds[c], SHUT_RDWR);
+	for (RK_S32 c = 0; c < g_coord_conn_count; c++) {
+		pthread_join(g_coord_conn_tids[c], RK_NULL);
+		close(g_coord_conn_fds[c]);
 	}
 
-	// 清理资源
-	sem_destroy(&g_iva_semaphore);
-	if (input_file_fd >= 0)
-		close(input_file_fd);
-	RK_MPI_MB_ReleaseMB(blk);
-	RK_MPI_MB_DestroyPool(pool_id);
-	program_normal_exit(__func__, __LINE__);
-	RK_LOGI("send_frame_to_iva_thread exit !!!");
-	return RK_NULL;
+	// 派发与回流对不上账就响亮报错并带失败码退出，不让残缺输出装成功
+	RK_S32 s32Ret = RK_SUCCESS;
+	RK_S32 pending = coord_requeue_pending() + g_coord_requeue_lost;
+	if (g_coord_frames_merged != yuv_file_count || pending > 0) {
+		RK_LOGE("coordinator merged %d of %d frames (%d still pending), "
+		        "merged output is INCOMPLETE",
+		        g_coord_frames_merged, yuv_file_count, pending);
+		s32Ret = RK_FAILURE;
+	} else {
+		RK_LOGI("coordinator done: %d of %d files merged", g_coord_frames_merged,
+		        yuv_file_count);
+	}
+	fclose(result_output_file);
+	result_output_file = NULL;
+	free_yuv_files();
+	return s32Ret;
 }
 
 /******************************************************************************
  * function    : main()
  * Description : main
  ******************************************************************************/
+static RK_S32 run_detect_job(char *directory_path, RK_U32 u32IvaWidth,
+                             RK_U32 u32IvaHeight, RK_U32 u32IvaDetectFrameRate,
+                             RK_S32 reuse_ctx);
+static RK_S32 run_jobs(const char *jobs_path);
+static RK_S32 run_coordinator(char *directory_path);
+
 int main(int argc, char *argv[]) {
 	// 默认配置参数
 	RK_U32 u32IvaWidth = 640;
@@ -429,7 +3342,6 @@ int main(int argc, char *argv[]) {
 
 	RK_S32 s32Ret;
 	RK_S32 s32SuspendTime = 1000;
-	pthread_t iva_thread_id;
 	char *directory_path = NULL;  // 添加目录路径变量
 
 	// 检查参数数量
@@ -438,8 +3350,16 @@ int main(int argc, char *argv[]) {
 		return 0;
 	}
 
+	// 退出事件fd（非阻塞：poll等待、read清零；建不出来就退回1秒轮询）
+	g_quit_evtfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (g_quit_evtfd < 0)
+		RK_LOGE("eventfd failed because %s, fall back to 1s polling", strerror(errno));
+
 	// 注册信号处理函数
 	signal(SIGINT, sigterm_handler);
+	signal(SIGUSR1, sigusr1_handler);
+	// SIGHUP触发模型热重载（覆盖模型文件或切符号链接后发信号即可）
+	signal(SIGHUP, sighup_handler);
 
 	printf("%s initial start\n", __func__);
 	int c;
@@ -479,6 +3399,167 @@ int main(int argc, char *argv[]) {
 		case 'o':
 			result_output_path = optarg;
 			break;
+		case OPT_PIPELINE_DEPTH:
+			g_pipeline_depth = atoi(optarg);
+			if (g_pipeline_depth < 1) {
+				RK_LOGE("invalid pipeline depth %d, fallback to 1", g_pipeline_depth);
+				g_pipeline_depth = 1;
+			}
+			break;
+		case OPT_MMAP_INPUT:
+			g_use_mmap_input = 1;
+			break;
+		case OPT_INSTANCES:
+			g_instance_count = atoi(optarg);
+			if (g_instance_count < 1) {
+				RK_LOGE("invalid instance count %d, fallback to 1", g_instance_count);
+				g_instance_count = 1;
+			}
+			break;
+		case OPT_RESULT_FORMAT:
+			if (strcmp(optarg, "bin") == 0) {
+				g_result_format_bin = 1;
+			} else if (strcmp(optarg, "txt") != 0) {
+				RK_LOGE("unknown result format %s, use txt", optarg);
+			}
+			break;
+		case OPT_BENCHMARK:
+			g_benchmark_mode = 1;
+			break;
+		case OPT_PRELOAD:
+			g_preload_enable = 1;
+			break;
+		case OPT_PRELOAD_MEM:
+			g_preload_mem_cap = (long long)atoi(optarg) * 1024 * 1024;
+			if (g_preload_mem_cap <= 0) {
+				RK_LOGE("invalid preload mem cap %s, fallback to 256MB", optarg);
+				g_preload_mem_cap = 256LL * 1024 * 1024;
+			}
+			break;
+		case OPT_BATCH:
+			g_batch_size = atoi(optarg);
+			if (g_batch_size < 1) {
+				RK_LOGE("invalid batch size %d, fallback to 1", g_batch_size);
+				g_batch_size = 1;
+			}
+			break;
+		case OPT_VIDEO:
+			g_video_path = optarg;
+			break;
+		case OPT_ANALYZE:
+			g_analyze_enable = 1;
+			break;
+		case OPT_READAHEAD:
+			g_readahead_depth = atoi(optarg);
+			if (g_readahead_depth < 0) {
+				RK_LOGE("invalid readahead depth %d, fallback to 2", g_readahead_depth);
+				g_readahead_depth = 2;
+			}
+			break;
+		case OPT_AUDIT:
+			g_audit_enable = 1;
+			break;
+		case OPT_RESUME:
+			g_resume_enable = 1;
+			break;
+		case OPT_ROI:
+			if (sscanf(optarg, "%d,%d,%d,%d", &g_roi_x, &g_roi_y,
+			           &g_roi_w, &g_roi_h) != 4 ||
+			    g_roi_x < 0 || g_roi_y < 0 || g_roi_w <= 0 || g_roi_h <= 0) {
+				RK_LOGE("invalid roi %s, expect x,y,w,h, fallback to full frame", optarg);
+				g_roi_x = g_roi_y = g_roi_w = g_roi_h = 0;
+			}
+			break;
+		case OPT_ROI_FILE:
+			g_roi_file_path = optarg;
+			break;
+		case OPT_JOBS:
+			g_jobs_path = optarg;
+			break;
+		case OPT_MODEL_CACHE:
+			g_model_cache_enable = 1;
+			break;
+		case OPT_REALTIME:
+			g_realtime_mode = 1;
+			break;
+		case OPT_SHM_PUBLISH:
+			g_shm_publish_enable = 1;
+			break;
+		case OPT_AFFINITY: {
+			char *tok = strtok(optarg, ",");
+			g_affinity_core_count = 0;
+			while (tok && g_affinity_core_count < AFFINITY_MAX_CORES) {
+				g_affinity_cores[g_affinity_core_count++] = atoi(tok);
+				tok = strtok(NULL, ",");
+			}
+			break;
+		}
+		case OPT_SCHED_FIFO:
+			g_sched_fifo_prio = atoi(optarg);
+			if (g_sched_fifo_prio < 1 || g_sched_fifo_prio > 99) {
+				RK_LOGE("invalid SCHED_FIFO priority %d, expect 1-99",
+				        g_sched_fifo_prio);
+				g_sched_fifo_prio = 0;
+			}
+			break;
+		case OPT_INPUT_SIZE:
+			if (sscanf(optarg, "%ux%u", &g_input_width, &g_input_height) != 2 ||
+			    g_input_width == 0 || g_input_height == 0 ||
+			    (g_input_width % 2) || (g_input_height % 2)) {
+				RK_LOGE("invalid input size %s, expect even WxH", optarg);
+				g_input_width = g_input_height = 0;
+			}
+			break;
+		case OPT_PREPROCESS:
+			if (strcmp(optarg, "crop") == 0) {
+				g_preprocess_crop = 1;
+			} else if (strcmp(optarg, "scale") == 0) {
+				g_preprocess_crop = 0;
+			} else {
+				RK_LOGE("invalid preprocess mode %s, expect scale or crop", optarg);
+			}
+			break;
+		case OPT_STDIN:
+			g_stdin_input = 1;
+			break;
+		case OPT_SOCKET:
+			g_socket_spec = optarg;
+			break;
+		case OPT_BENCH_SUITE:
+			g_bench_suite_path = optarg;
+			break;
+		case OPT_GOLDEN:
+			g_golden_dir = optarg;
+			break;
+		case OPT_FILTER_TYPES: {
+			char *tok = strtok(optarg, ",");
+			while (tok) {
+				RK_S32 known = 0;
+				for (RK_S32 t = 0;
+				     t < (RK_S32)(sizeof(g_type_str) / sizeof(g_type_str[0])); t++) {
+					if (strcasecmp(tok, g_type_str[t]) == 0) {
+						g_filter_type_mask |= 1u << t;
+						known = 1;
+						break;
+					}
+				}
+				if (!known)
+					RK_LOGE("unknown object type %s in filter_types", tok);
+				tok = strtok(NULL, ",");
+			}
+			break;
+		}
+		case OPT_MIN_SCORE:
+			g_min_score = atoi(optarg);
+			if (g_min_score < 0)
+				g_min_score = 0;
+			break;
+		case OPT_COORDINATOR:
+			g_coordinator_port = optarg;
+			break;
+		case OPT_WORKER:
+			g_worker_spec = optarg;
+			break;
 		case '?':
 		default:
 			print_usage(argv[0]);
@@ -486,6 +3567,167 @@ int main(int argc, char *argv[]) {
 		}
 	}
 	
+	// 批量大小不能超过流水线深度，否则批内永远凑不满K个已装载缓冲
+	if (g_batch_size > g_pipeline_depth) {
+		RK_LOGI("raise pipeline depth %d to batch size %d", g_pipeline_depth, g_batch_size);
+		g_pipeline_depth = g_batch_size;
+	}
+
+	// 输入尺寸与模型尺寸一致时前处理是空转，直接关掉
+	if (g_input_width == u32IvaWidth && g_input_height == u32IvaHeight)
+		g_input_width = g_input_height = 0;
+
+	// 基准套件隐含基准模式与二进制结果格式（紧凑且可机读对比）
+	if (g_bench_suite_path) {
+		g_benchmark_mode = 1;
+		g_result_format_bin = 1;
+	}
+
+	// 模型热缓存：Create之前把模型目录切到/dev/shm的常驻副本
+	if (g_model_cache_enable && model_cache_init() != RK_SUCCESS) {
+		RK_LOGE("model cache init failed, fall back to %s", pIvaModelPath);
+		g_model_cache_enable = 0;
+	}
+
+	// 共享内存结果总线（任务队列模式下跨任务共用同一个环）
+	if (g_shm_publish_enable && shm_publish_init() != RK_SUCCESS) {
+		RK_LOGE("result bus init failed, results go to file only");
+		g_shm_publish_enable = 0;
+	}
+
+	// 工作端模式：先连上协调端，结果强制二进制格式整段回传
+	if (g_worker_spec) {
+		if (worker_connect(g_worker_spec) != RK_SUCCESS)
+			return RK_FAILURE;
+		g_result_format_bin = 1;
+	}
+
+	// 初始化系统（整个进程只做一次，任务队列模式下跨任务复用；
+	// 协调端只派活和合并结果，不碰NPU，跳过MPI初始化）
+	if (!g_coordinator_port)
+		RK_MPI_SYS_Init();
+
+	// 协调端/基准套件/任务清单模式逐项执行；否则按命令行参数跑单个任务
+	if (g_coordinator_port)
+		s32Ret = run_coordinator(directory_path);
+	else if (g_bench_suite_path)
+		s32Ret = run_jobs(g_bench_suite_path);
+	else if (g_jobs_path)
+		s32Ret = run_jobs(g_jobs_path);
+	else
+		s32Ret = run_detect_job(directory_path, u32IvaWidth, u32IvaHeight,
+		                        u32IvaDetectFrameRate, 0);
+
+	// 退出系统
+	if (!g_coordinator_port)
+		RK_MPI_SYS_Exit();
+
+	// 工作端模式：断开协调端连接
+	if (g_worker_fd >= 0) {
+		close(g_worker_fd);
+		g_worker_fd = -1;
+	}
+
+	// 解除模型缓存映射（shm对象留给下次启动）
+	model_cache_deinit();
+
+	// 解除结果总线映射（shm对象留给消费者读完尾巴）
+	shm_publish_deinit();
+
+	// 释放逐文件ROI清单
+	free(g_roi_entries);
+	g_roi_entries = NULL;
+	g_roi_entry_count = 0;
+
+	// 关闭退出事件fd
+	if (g_quit_evtfd >= 0) {
+		close(g_quit_evtfd);
+		g_quit_evtfd = -1;
+	}
+
+	return s32Ret;
+}
+
+// 模型热重载（SIGHUP触发）：以前换模型要杀进程冷启动，RK_MPI_SYS_Init、
+// 建内存池、索引几十万文件、填预载缓存全部重来一遍。A/B测模型时这些
+// 都没变，真正要换的只有IVA上下文。流程：置起暂停闸让各提交线程停在
+// 暂停点，等在途帧全部被IVA释放，再逐实例Destroy/Create——Create会
+// 重新从pIvaModelPath读模型文件，所以换模型=覆盖模型文件（或切符号
+// 链接）后发SIGHUP。内存池、yuv_files索引、预载缓存、file_cursor全部
+// 原地保留，放行后流水线从停下的位置继续
+static void model_reload(void) {
+	RK_S32 k, w;
+	long t0 = get_time_ms();
+
+	RK_LOGI("SIGHUP: model hot reload requested, quiescing pipeline");
+	g_reload_pause = 1;
+
+	// 等所有提交线程到达暂停点且在途帧清零（最多等10秒）
+	for (w = 0; w < 10000 && !quit; w++) {
+		RK_S32 busy = (g_paused_senders < g_active_senders);
+		for (k = 0; k < g_instance_count; k++)
+			if (g_instances[k].frames_released < g_instances[k].frames_pushed)
+				busy = 1;
+		if (!busy)
+			break;
+		usleep(1000);
+	}
+	if (w >= 10000 || quit) {
+		RK_LOGE("model reload: quiesce failed, keep running with old model");
+		g_reload_pause = 0;
+		return;
+	}
+
+	// 模型热缓存：同尺寸换内容时按大小判断会误判"已暖"，强制从
+	// 原始目录重灌一遍（init失败则目录留在原处，Create直接读源文件）
+	if (g_model_cache_enable && g_model_cache_src_dir) {
+		model_cache_deinit();
+		shm_unlink(pIvaModelName);
+		pIvaModelPath = g_model_cache_src_dir;
+		if (model_cache_init() != RK_SUCCESS)
+			RK_LOGE("model reload: refill model cache failed, read from source");
+	}
+
+	for (k = 0; k < g_instance_count; k++) {
+		IVA_INSTANCE_S *inst = &g_instances[k];
+		SAMPLE_COMM_IVA_Destroy(&inst->iva_ctx);
+		// 新上下文会重建库内回调线程，绑核/提优先级下次回调重做
+		inst->cb_tuned = 0;
+		inst->release_cb_tuned = 0;
+		if (SAMPLE_COMM_IVA_Create(&inst->iva_ctx) != RK_SUCCESS) {
+			RK_LOGE("model reload: recreate inst %d failed", k);
+			program_handle_error(__func__, __LINE__);
+			g_reload_pause = 0;
+			return;
+		}
+	}
+
+	RK_LOGI("model reload done in %ld ms, pipeline resumes",
+	        get_time_ms() - t0);
+	g_reload_pause = 0;
+}
+
+// 执行一个检测任务：装载输入、建IVA实例、跑流水线、汇总并清理。
+// reuse_ctx为真时沿用上一任务留下的IVA上下文和内存池（分辨率必须相同）
+static RK_S32 run_detect_job(char *directory_path, RK_U32 u32IvaWidth,
+                             RK_U32 u32IvaHeight, RK_U32 u32IvaDetectFrameRate,
+                             RK_S32 reuse_ctx) {
+	RK_S32 s32Ret;
+
+	// 断点文件路径跟着本任务的结果文件走
+	g_ckpt_path[0] = '\0';
+
+	// 处理yuvseq容器模式：-p指向.yuvseq文件时走单文件pread路径
+	if (path && is_yuvseq_file(path)) {
+	    if (yuvseq_open(path, u32IvaWidth, u32IvaHeight) != RK_SUCCESS) {
+	        return RK_FAILURE;
+	    }
+	    // 默认循环次数为容器内的帧数（-p默认已置1，这里覆盖掉）
+	    if (loop_count <= 1) {
+	        loop_count = g_yuvseq_frames;
+	    }
+	}
+
 	// 处理目录模式
 	if (directory_path) {
 	    if (scan_yuv_directory(directory_path) < 0) {
@@ -500,10 +3742,37 @@ int main(int argc, char *argv[]) {
 	    // 默认情况下至少运行一次
 	    loop_count = 1;
 	}
-	
+
+	// 检测子窗口必须落在图像内，越界则退回全幅
+	if (g_roi_w > 0 && g_roi_h > 0 &&
+	    ((RK_U32)(g_roi_x + g_roi_w) > u32IvaWidth ||
+	     (RK_U32)(g_roi_y + g_roi_h) > u32IvaHeight)) {
+		RK_LOGE("roi %d,%d,%d,%d exceeds image %ux%u, fallback to full frame",
+		        g_roi_x, g_roi_y, g_roi_w, g_roi_h, u32IvaWidth, u32IvaHeight);
+		g_roi_x = g_roi_y = g_roi_w = g_roi_h = 0;
+	}
+
+	// 读入逐文件ROI清单（仅目录模式有意义）
+	if (g_roi_file_path && roi_file_load(g_roi_file_path) != RK_SUCCESS)
+		g_roi_file_path = NULL;
+
 	// 如果指定了结果输出文件路径，则打开文件
 	if (result_output_path) {
-		result_output_file = fopen(result_output_path, "w");
+		snprintf(g_ckpt_path, sizeof(g_ckpt_path), "%s.ckpt", result_output_path);
+
+		// 断点续跑：先裁掉上次崩溃留下的残尾，再以追加方式打开
+		if (g_resume_enable && ckpt_load() == RK_SUCCESS) {
+			if (truncate(result_output_path, (off_t)g_ckpt_result_offset) < 0)
+				RK_LOGE("truncate %s to %lld failed because %s", result_output_path,
+				        g_ckpt_result_offset, strerror(errno));
+		} else if (g_resume_enable) {
+			RK_LOGI("no checkpoint at %s, start from scratch", g_ckpt_path);
+			g_resume_enable = 0;
+		}
+
+		result_output_file = fopen(result_output_path,
+		                           g_resume_enable ? (g_result_format_bin ? "ab" : "a")
+		                                           : (g_result_format_bin ? "wb" : "w"));
 		if (!result_output_file) {
 			RK_LOGE("Failed to open result output file: %s", result_output_path);
 			// 清理资源
@@ -511,57 +3780,347 @@ int main(int argc, char *argv[]) {
 			return RK_FAILURE;
 		}
 		RK_LOGI("Result output file opened: %s", result_output_path);
+
+		// 二进制模式：写文件头并分配聚合缓冲（续跑时文件头已经在了）
+		if (g_result_format_bin) {
+			RESULT_BIN_HEADER_S bin_header = {RESULT_BIN_MAGIC, RESULT_BIN_VERSION};
+			if (!(g_resume_enable && g_ckpt_result_offset >= (long long)sizeof(bin_header)))
+				fwrite(&bin_header, sizeof(bin_header), 1, result_output_file);
+			g_result_bin_buf = (RK_U8 *)malloc(RESULT_BIN_BUF_SIZE);
+			if (!g_result_bin_buf) {
+				RK_LOGE("allocate result bin buffer failed");
+				fclose(result_output_file);
+				free_yuv_files();
+				return RK_FAILURE;
+			}
+			g_result_bin_last_flush_ms = get_time_ms();
+		}
 	}
 
-	// 初始化系统
-	RK_MPI_SYS_Init();
-
-	/* 初始化IVA */
-	iva_ctx.pModelDataPath = pIvaModelPath;
-	iva_ctx.commonParams.detModelName = pIvaModelName;
-	iva_ctx.u32ImageWidth = u32IvaWidth;
-	iva_ctx.u32ImageHeight = u32IvaHeight;
-	iva_ctx.u32DetectStartX = 0;
-	iva_ctx.u32DetectStartY = 0;
-	iva_ctx.u32DetectWidth = u32IvaWidth;
-	iva_ctx.u32DetectHight = u32IvaHeight;
-	iva_ctx.eImageTransform = ROCKIVA_IMAGE_TRANSFORM_NONE;
-	iva_ctx.eImageFormat = ROCKIVA_IMAGE_FORMAT_YUV420SP_NV12;
-	iva_ctx.eModeType = ROCKIVA_DET_MODEL_PFP;
-	iva_ctx.u32IvaDetectFrameRate = u32IvaDetectFrameRate;
-	iva_ctx.detectResultCallback = rkIvaEvent_callback;
-	iva_ctx.releaseCallback = rkIvaFrame_releaseCallBack;
-	iva_ctx.eIvaMode = ROCKIVA_MODE_DETECT;
-	s32Ret = SAMPLE_COMM_IVA_Create(&iva_ctx);
-	if (s32Ret != RK_SUCCESS) {
-		RK_LOGE("SAMPLE_COMM_IVA_Create failure:%#X", s32Ret);
-		// 清理资源
-		free_yuv_files();
-		return RK_FAILURE;
+	// 在线分析：打开各得分区间的清单文件
+	if (g_analyze_enable && analyze_init() != RK_SUCCESS) {
+		RK_LOGE("analyze init failed, disable online analysis");
+		g_analyze_enable = 0;
 	}
-	
-	// 创建发送帧到IVA的线程
-	pthread_create(&iva_thread_id, 0, send_frame_to_iva_thread, NULL);
+
+	// 压缩视频输入：创建VDEC通道（单码流只支持单实例）
+	if (g_video_path) {
+		if (g_instance_count > 1) {
+			RK_LOGE("video input supports one instance only, clamp %d to 1",
+			        g_instance_count);
+			g_instance_count = 1;
+		}
+		// 视频模式帧数未知，不设循环上限，由SIGINT结束
+		loop_count = -1;
+		if (vdec_input_init(u32IvaWidth, u32IvaHeight) != RK_SUCCESS) {
+			free_yuv_files();
+			return RK_FAILURE;
+		}
+	}
+
+	// 流式输入：打开管道/套接字（单一字节流无法分片，只支持单实例）
+	if (g_stdin_input || g_socket_spec) {
+		if (g_instance_count > 1) {
+			RK_LOGE("stream input supports one instance only, clamp %d to 1",
+			        g_instance_count);
+			g_instance_count = 1;
+		}
+		// 帧数由上游决定，不设循环上限，EOF或SIGINT结束
+		loop_count = -1;
+		if (stream_input_open() != RK_SUCCESS) {
+			free_yuv_files();
+			return RK_FAILURE;
+		}
+	}
+
+	// 工作端模式：下标由协调端下发（单连接单游标，只支持单实例），
+	// 帧数由派发决定，不设循环上限
+	if (g_worker_fd >= 0) {
+		if (!yuv_files || yuv_file_count <= 0) {
+			RK_LOGE("worker mode requires -d directory input");
+			free_yuv_files();
+			return RK_FAILURE;
+		}
+		if (g_instance_count > 1) {
+			RK_LOGE("worker mode supports one instance only, clamp %d to 1",
+			        g_instance_count);
+			g_instance_count = 1;
+		}
+		loop_count = -1;
+		// 没有本地结果文件也要有聚合缓冲，满了整段发回协调端
+		if (!g_result_bin_buf) {
+			g_result_bin_buf = (RK_U8 *)malloc(RESULT_BIN_BUF_SIZE);
+			if (!g_result_bin_buf) {
+				RK_LOGE("allocate result bin buffer failed");
+				free_yuv_files();
+				return RK_FAILURE;
+			}
+			g_result_bin_last_flush_ms = get_time_ms();
+		}
+	}
+
+	// 内存预检：建池之前按CMA余量裁剪流水线深度
+	// （复用上下文时池和槽位已按旧深度建好，不再改动）
+	if (!reuse_ctx)
+		mem_preflight(u32IvaWidth * u32IvaHeight * 3 / 2);
+
+	// 预载模式：启动时把目录内容一次性装进DMA缓存
+	if (g_preload_enable) {
+		if (preload_init(u32IvaWidth * u32IvaHeight * 3 / 2) != RK_SUCCESS) {
+			RK_LOGE("preload init failed");
+			free_yuv_files();
+			return RK_FAILURE;
+		}
+	}
+
+	// 计算分片基数：目录模式按文件数，yuvseq模式按帧数
+	RK_S32 shard_total = 0;
+	if (yuv_files && yuv_file_count > 0)
+		shard_total = yuv_file_count;
+	else if (g_yuvseq_fd >= 0)
+		shard_total = g_yuvseq_frames;
+	// 实例数不能超过可分片的条目数
+	if (shard_total > 0 && g_instance_count > shard_total) {
+		RK_LOGE("instance count %d exceeds %d input entries, clamp",
+		        g_instance_count, shard_total);
+		g_instance_count = shard_total;
+	}
+
+	/* 初始化IVA实例（--instances大于1时并行驱动多个NPU核） */
+	if (!reuse_ctx) {
+		g_instances = (IVA_INSTANCE_S *)calloc(g_instance_count, sizeof(IVA_INSTANCE_S));
+		if (!g_instances) {
+			RK_LOGE("allocate instances failed");
+			free_yuv_files();
+			return RK_FAILURE;
+		}
+		for (RK_S32 k = 0; k < g_instance_count; k++) {
+			IVA_INSTANCE_S *inst = &g_instances[k];
+			inst->inst_id = k;
+			inst->iva_ctx.pModelDataPath = pIvaModelPath;
+			inst->iva_ctx.commonParams.detModelName = pIvaModelName;
+			inst->iva_ctx.u32ImageWidth = u32IvaWidth;
+			inst->iva_ctx.u32ImageHeight = u32IvaHeight;
+			// 检测子窗口：--roi指定则只在该区域内跑检测，否则全幅
+			if (g_roi_w > 0 && g_roi_h > 0) {
+				inst->iva_ctx.u32DetectStartX = g_roi_x;
+				inst->iva_ctx.u32DetectStartY = g_roi_y;
+				inst->iva_ctx.u32DetectWidth = g_roi_w;
+				inst->iva_ctx.u32DetectHight = g_roi_h;
+			} else {
+				inst->iva_ctx.u32DetectStartX = 0;
+				inst->iva_ctx.u32DetectStartY = 0;
+				inst->iva_ctx.u32DetectWidth = u32IvaWidth;
+				inst->iva_ctx.u32DetectHight = u32IvaHeight;
+			}
+			inst->iva_ctx.eImageTransform = ROCKIVA_IMAGE_TRANSFORM_NONE;
+			inst->iva_ctx.eImageFormat = ROCKIVA_IMAGE_FORMAT_YUV420SP_NV12;
+			inst->iva_ctx.eModeType = ROCKIVA_DET_MODEL_PFP;
+			inst->iva_ctx.u32IvaDetectFrameRate = u32IvaDetectFrameRate;
+			inst->iva_ctx.detectResultCallback = rkIvaEvent_callback;
+			inst->iva_ctx.releaseCallback = rkIvaFrame_releaseCallBack;
+			inst->iva_ctx.eIvaMode = ROCKIVA_MODE_DETECT;
+
+			s32Ret = SAMPLE_COMM_IVA_Create(&inst->iva_ctx);
+			if (s32Ret != RK_SUCCESS) {
+				RK_LOGE("SAMPLE_COMM_IVA_Create (inst %d) failure:%#X", k, s32Ret);
+				// 清理已创建的实例
+				for (RK_S32 j = 0; j < k; j++)
+					SAMPLE_COMM_IVA_Destroy(&g_instances[j].iva_ctx);
+				free(g_instances);
+				g_instances = NULL;
+				free_yuv_files();
+				return RK_FAILURE;
+			}
+		}
+	} else {
+		// 相邻任务分辨率相同：沿用上一任务的IVA上下文，跳过模型重载
+		RK_LOGI("reuse %d IVA context(s) from previous job", g_instance_count);
+	}
+
+	for (RK_S32 k = 0; k < g_instance_count; k++) {
+		IVA_INSTANCE_S *inst = &g_instances[k];
+		// 清掉上一任务的运行状态（新建实例时calloc已清零，重置无害）
+		inst->frames_pushed = 0;
+		inst->frames_released = 0;
+		inst->results_received = 0;
+		inst->inflight_wr = 0;
+		inst->inflight_rd = 0;
+		inst->files_read = 0;
+		inst->readahead_stop = 0;
+		inst->skip_request = 0;
+		inst->frames_skipped = 0;
+		inst->reader_done = 0;
+		inst->cb_tuned = 0;
+		inst->release_cb_tuned = 0;
+		inst->run_complete = 0;
+		inst->last_result_us = 0;
+		// 帧率变化只影响提交限速，不需要重建上下文
+		inst->iva_ctx.u32IvaDetectFrameRate = u32IvaDetectFrameRate;
+
+		// 输入分片：实例k处理[k*total/N, (k+1)*total/N)区间
+		if (shard_total > 0) {
+			inst->file_begin = (RK_S32)((RK_S64)shard_total * k / g_instance_count);
+			inst->file_end = (RK_S32)((RK_S64)shard_total * (k + 1) / g_instance_count);
+			inst->file_cursor = inst->file_begin;
+			// 按分片占比分摊总循环次数
+			if (loop_count < 0)
+				inst->loop_count = -1;
+			else
+				inst->loop_count = (RK_S32)((RK_S64)loop_count * (inst->file_end - inst->file_begin) / shard_total);
+		} else {
+			// 单文件模式：循环次数在实例间平均分摊
+			inst->file_begin = 0;
+			inst->file_end = 0;
+			inst->file_cursor = 0;
+			if (loop_count < 0)
+				inst->loop_count = -1;
+			else
+				inst->loop_count = loop_count / g_instance_count +
+				                   (k < loop_count % g_instance_count ? 1 : 0);
+		}
+
+		// 断点续跑：把已完成的帧数折算进游标和剩余循环次数
+		// （要求与上次运行相同的实例数和输入，分片才对得上）
+		if (g_resume_enable && g_ckpt_loaded && k < CKPT_MAX_INST && g_ckpt_done[k] > 0) {
+			RK_U32 done = g_ckpt_done[k];
+			RK_S32 shard_len = inst->file_end - inst->file_begin;
+			if (inst->loop_count > 0)
+				inst->loop_count = (RK_S32)done >= inst->loop_count
+				                       ? 0
+				                       : inst->loop_count - (RK_S32)done;
+			if (shard_len > 0)
+				inst->file_cursor = inst->file_begin + (RK_S32)(done % (RK_U32)shard_len);
+			RK_LOGI("inst %d resume: %u frames done, cursor %d, %d remaining",
+			        k, done, inst->file_cursor, inst->loop_count);
+		}
+	}
+
+	// 为每个实例创建发送帧到IVA的线程
+	for (RK_S32 k = 0; k < g_instance_count; k++)
+		pthread_create(&g_instances[k].send_thread_id, 0, send_frame_to_iva_thread,
+		               &g_instances[k]);
 
 	printf("%s initial finish\n", __func__);
-	// 主线程等待退出信号
+	// 主线程等退出事件：quit一置位立即醒来，不再被sleep(1)拖住；
+	// poll超时1秒用于周期性杂务（断点落盘、审计基线、统计导出）
+	quit_evtfd_drain();
+	RK_S32 ckpt_tick = 0;
 	while (!quit) {
-		sleep(1);
+		if (g_quit_evtfd >= 0) {
+			struct pollfd pfd;
+			pfd.fd = g_quit_evtfd;
+			pfd.events = POLLIN;
+			poll(&pfd, 1, 1000);
+			quit_evtfd_drain();
+		} else {
+			sleep(1);
+		}
+		// 周期性落盘进度断点
+		if (g_ckpt_path[0] && result_output_file && ++ckpt_tick >= CKPT_INTERVAL_S) {
+			ckpt_tick = 0;
+			ckpt_write();
+		}
+		// 审计模式：流水线跑起来之后记录堆占用基线，
+		// 之后的任何增长都是稳态路径上的意外分配
+		if (g_audit_enable && !g_audit_baseline_taken) {
+			g_audit_heap_baseline = (size_t)mallinfo().uordblks;
+			g_audit_baseline_taken = 1;
+		}
+		// SIGUSR1请求的统计导出在这里安全执行
+		if (g_stage_dump_requested) {
+			g_stage_dump_requested = 0;
+			stage_stats_dump();
+		}
+		// SIGHUP请求的模型热重载同样在主线程串行执行
+		if (g_reload_requested) {
+			g_reload_requested = 0;
+			model_reload();
+		}
 	}
 
 	printf("%s exit!\n", __func__);
-	/* 销毁IVA */
-	pthread_join(iva_thread_id, RK_NULL);
-	SAMPLE_COMM_IVA_Destroy(&iva_ctx);
+	/* 销毁IVA（任务队列要复用上下文时留给下一个任务） */
+	for (RK_S32 k = 0; k < g_instance_count; k++) {
+		pthread_join(g_instances[k].send_thread_id, RK_NULL);
+		if (!g_job_keep_ctx)
+			SAMPLE_COMM_IVA_Destroy(&g_instances[k].iva_ctx);
+	}
+
+	// 基准模式：汇总输出吞吐与延迟分位数
+	if (g_benchmark_mode)
+		benchmark_report();
+
+	// 审计模式：输出稳态分配与系统调用结论
+	if (g_audit_enable)
+		audit_report();
+
+	// 退出时导出分阶段统计
+	stage_stats_dump();
+
+	// 在线分析：回调已停，收尾出清单和汇总
+	if (g_analyze_enable)
+		analyze_finish();
+
+	// 整个任务自然跑完才删断点文件；被SIGINT/出错打断时保留最终进度，
+	// 下次--resume还能接着跑
+	if (g_ckpt_path[0]) {
+		RK_S32 all_complete = 1;
+		for (RK_S32 k = 0; k < g_instance_count; k++)
+			if (!g_instances[k].run_complete)
+				all_complete = 0;
+		if (all_complete)
+			remove(g_ckpt_path);
+		else if (result_output_file)
+			ckpt_write();
+	}
+
+	// 实例数组在跨任务复用时保留
+	if (!g_job_keep_ctx) {
+		free(g_instances);
+		g_instances = NULL;
+	}
+
+	// 释放预载缓存
+	preload_deinit();
+
+	// 销毁VDEC通道
+	vdec_input_deinit();
+
+	// 关闭流式输入
+	stream_input_close();
 
-	// 退出系统
-	RK_MPI_SYS_Exit();
-	
 	// 清理资源
 	free_yuv_files();
-	
-	// 关闭结果输出文件
+
+	// 关闭yuvseq容器文件并释放预格式化名表
+	if (g_yuvseq_fd >= 0) {
+		close(g_yuvseq_fd);
+		g_yuvseq_fd = -1;
+	}
+	free(g_yuvseq_names);
+	g_yuvseq_names = NULL;
+	free(g_yuvseq_name_arena);
+	g_yuvseq_name_arena = NULL;
+
+	// 工作端模式：把残留结果发干净（连接留给main统一关闭）
+	if (g_worker_fd >= 0 && g_result_bin_buf) {
+		pthread_mutex_lock(&g_result_file_mutex);
+		result_bin_flush();
+		pthread_mutex_unlock(&g_result_file_mutex);
+		free(g_result_bin_buf);
+		g_result_bin_buf = NULL;
+	}
+
+	// 关闭结果输出文件（二进制模式先把聚合缓冲刷干净）
 	if (result_output_file) {
+		if (g_result_format_bin) {
+			pthread_mutex_lock(&g_result_file_mutex);
+			result_bin_flush();
+			pthread_mutex_unlock(&g_result_file_mutex);
+			free(g_result_bin_buf);
+			g_result_bin_buf = NULL;
+		}
 		fclose(result_output_file);
 		result_output_file = NULL;
 	}
@@ -569,6 +4128,114 @@ int main(int argc, char *argv[]) {
 	return quit_result;
 }
 
+// 解析并执行任务清单：每行"目录 宽 高 帧率 结果文件"，#开头为注释行，
+// 结果文件写"-"表示本任务不落盘结果
+static RK_S32 run_jobs(const char *jobs_path) {
+	FILE *fp = fopen(jobs_path, "r");
+	if (!fp) {
+		RK_LOGE("open jobs file %s failed because %s", jobs_path, strerror(errno));
+		return RK_FAILURE;
+	}
+
+	RK_S32 cap = 16;
+	RK_S32 count = 0;
+	JOB_ENTRY_S *jobs = (JOB_ENTRY_S *)malloc(cap * sizeof(JOB_ENTRY_S));
+	if (!jobs) {
+		fclose(fp);
+		return RK_FAILURE;
+	}
+
+	char line[1024];
+	while (fgets(line, sizeof(line), fp)) {
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+		if (count >= cap) {
+			cap *= 2;
+			JOB_ENTRY_S *grown = (JOB_ENTRY_S *)realloc(jobs, cap * sizeof(JOB_ENTRY_S));
+			if (!grown)
+				break;
+			jobs = grown;
+		}
+		JOB_ENTRY_S *job = &jobs[count];
+		if (sscanf(line, "%255s %u %u %u %255s", job->dir, &job->width,
+		           &job->height, &job->rate, job->output) == 5)
+			count++;
+		else
+			RK_LOGE("skip malformed job line: %s", line);
+	}
+	fclose(fp);
+
+	if (count == 0) {
+		RK_LOGE("jobs file %s has no valid entries", jobs_path);
+		free(jobs);
+		return RK_FAILURE;
+	}
+	RK_LOGI("jobs file %s loaded, %d jobs", jobs_path, count);
+
+	RK_S32 ret = RK_SUCCESS;
+	for (RK_S32 j = 0; j < count; j++) {
+		JOB_ENTRY_S *job = &jobs[j];
+		// 相邻任务分辨率相同时复用IVA上下文和内存池
+		RK_S32 reuse = j > 0 && g_instances != NULL &&
+		               jobs[j - 1].width == job->width &&
+		               jobs[j - 1].height == job->height;
+		g_job_keep_ctx = (j + 1 < count) &&
+		                 jobs[j + 1].width == job->width &&
+		                 jobs[j + 1].height == job->height;
+
+		// 重置上一任务留下的运行状态
+		quit = false;
+		quit_result = RK_SUCCESS;
+		g_instances_done = 0;
+		loop_count = -1;
+		path = NULL;
+		result_output_path = strcmp(job->output, "-") ? job->output : NULL;
+
+		RK_LOGI("job %d/%d: %s %ux%u @%ufps -> %s", j + 1, count, job->dir,
+		        job->width, job->height, job->rate,
+		        result_output_path ? result_output_path : "(none)");
+		ret = run_detect_job(job->dir, job->width, job->height, job->rate, reuse);
+		if (ret != RK_SUCCESS || g_got_sigint)
+			break;
+
+		// 基准套件：结果文件已关闭落盘，写性能基线并与黄金结果对比
+		if (g_bench_suite_path && result_output_path) {
+			bench_perf_write(result_output_path);
+			if (g_golden_dir)
+				bench_diff_job(result_output_path);
+		}
+	}
+
+	// 出错或SIGINT提前退出时，收掉为下一任务保留的上下文和内存池
+	g_job_keep_ctx = 0;
+	if (g_instances) {
+		for (RK_S32 k = 0; k < g_instance_count; k++) {
+			IVA_INSTANCE_S *inst = &g_instances[k];
+			if (inst->slots) {
+				for (RK_S32 i = 0; i < g_pipeline_depth; i++) {
+					if (inst->slots[i].blk != MB_INVALID_HANDLE)
+						RK_MPI_MB_ReleaseMB(inst->slots[i].blk);
+				}
+				free(inst->slots);
+				inst->slots = NULL;
+				free(inst->pre_buf);
+				inst->pre_buf = NULL;
+				RK_MPI_MB_DestroyPool(inst->pool_id);
+				__sync_fetch_and_sub(&g_mem_pool_bytes,
+				                     (long long)inst->iva_ctx.u32ImageWidth *
+				                         inst->iva_ctx.u32ImageHeight * 3 / 2 *
+				                         g_pipeline_depth);
+			}
+			SAMPLE_COMM_IVA_Destroy(&inst->iva_ctx);
+		}
+		free(g_instances);
+		g_instances = NULL;
+	}
+
+	free(jobs);
+	return ret;
+}
+
 #ifdef __cplusplus
 #if __cplusplus
 }